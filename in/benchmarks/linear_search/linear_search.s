@@ -0,0 +1,28 @@
+// Busca linear em assembly: procura CHAVE no vetor de N palavras e grava
+// em achou 1 se encontrou. Mesmo laco de linear_search.txt, com os
+// registradores e a memoria definidos pelo proprio programa
+.equ N,500
+.equ CHAVE,42
+
+.data
+vetor:  .space N-1
+        .word CHAVE
+achou:  .word 0
+
+.text
+        DADDI R5,R0,vetor
+        DADDI R6,R0,N
+        DADDI R7,R0,CHAVE
+        DADD R11,R0,R0
+        DADD R1,R0,R0
+        BEQ R11,R6,fim
+laco:   DADD R20,R5,R11
+        LD R21,0(R20)
+        BEQ R21,R7,encontrou
+        DADDI R11,R11,1
+        BNE R11,R6,laco
+        J fim
+encontrou:
+        DADDI R1,R0,1
+        SD R1,achou(R0)
+fim:    DADD R0,R0,R0
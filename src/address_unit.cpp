@@ -8,6 +8,9 @@ instruct_table(instr_t),
 res_station_table(rst_t),
 rst_tam(rst_tm)
 {
+    isFlushed = stale_issue = false;
+    flush_count = 0;
+    rob_pos = 0;
     SC_THREAD(leitura_issue);
     sensitive << in_issue;
     dont_initialize();
@@ -38,12 +41,14 @@ void address_unit::leitura_issue()
            rst_pos - 0
            ord = {"LD", "R6", "0(R3)", "3", "1", "4", "0"} */
         in_issue->read(p);
+        isFlushed = stale_issue;
+        stale_issue = false;
         ord = instruction_split(p);
+        rob_pos = std::stoi(ord[5]);
         wait(sc_time(1,SC_NS));
         mem_ord = offset_split(ord[2]);
         a = std::stoi(mem_ord[0]);
         instr_pos = std::stoi(ord[3]);
-        rob_pos = std::stoi(ord[5]);
         regst = ask_status(true,mem_ord[1]);
         check_value = false;
         if(regst != 0)
@@ -59,6 +64,12 @@ void address_unit::leitura_issue()
             store = true;
         else
             store = false;
+        //Instrucao descartada pelo flush do ROB enquanto lia os operandos
+        if(isFlushed)
+        {
+            wait_issue();
+            continue;
+        }
         if(!store)
         {
             // Anteriormente era ord[5]
@@ -74,6 +85,11 @@ void address_unit::leitura_issue()
             if(check_value == false)
                 value = ask_value(mem_ord[1]);
             wait(SC_ZERO_TIME);
+            if(isFlushed)
+            {
+                wait_issue();
+                continue;
+            }
             instruct_table.at(instr_pos).text(EXEC,std::to_string(sc_time_stamp().value() / 1000)); //text(EXEC,"X");
             a += value;
             if(store)
@@ -95,10 +111,20 @@ void address_unit::leitura_issue()
                 res_station_table.at(rst_pos+rst_tam).text(QK,std::to_string(regst));
             cout << "Instrucao " << ord[0] << " aguardando o resultado do ROB " << regst << endl << flush;
         }
-        wait();
+        wait_issue();
     }
 }
 
+//Espera o proximo issue, que pode ter chegado enquanto a unidade aguardava
+//o banco de registradores
+void address_unit::wait_issue()
+{
+    string p_i = "";
+    in_issue->nb_read(p_i);
+    if(p_i == "" || p_i == " ")
+        wait();
+}
+
 void address_unit::leitura_cdb()
 {
     string p_c;
@@ -113,7 +139,13 @@ void address_unit::leitura_cdb()
             if(std::stoi(ord_c[0]) == offset_buff[i].regst)
             {
                 offset_buff[i].a+= std::stoi(ord_c[1]);
+                int tag = offset_buff[i].rob_pos;
                 wait(SC_ZERO_TIME);
+                //Buffer alterado por um flush do ROB no mesmo ciclo
+                for(i = 0 ; i < offset_buff.size() && offset_buff[i].rob_pos != tag ; i++)
+                    ;
+                if(i >= offset_buff.size())
+                    break;
                 instruct_table.at(offset_buff[i].instr_pos).text(EXEC,std::to_string(sc_time_stamp().value() / 1000)); //text(EXEC,"X")
                 if(offset_buff[i].store)
                 {
@@ -143,16 +175,20 @@ void address_unit::leitura_cdb()
 void address_unit::addr_issue()
 {
     addr_node fr;
+    unsigned int gen;
     while(true)
     {
         while(addr_queue.empty())
             wait(addr_queue_event);
         fr = addr_queue.front();
+        gen = flush_count;
         if(fr.store)
             out_rob->write(std::to_string(fr.rob_pos) + ' ' + std::to_string(fr.a));
         else
             out_slbuff->write(std::to_string(fr.rob_pos) + ' ' + std::to_string(fr.a));
-        addr_queue.pop();
+        //Um flush durante a escrita ja esvaziou a fila
+        if(gen == flush_count)
+            addr_queue.pop();
         wait(1,SC_NS);
     }
 }
@@ -163,11 +199,34 @@ void address_unit::leitura_rob()
     while(1)
     {
         in_rob->read(p);
-        if(p == "F")
+        if(is_flush(p))
         {
-            queue<addr_node> empty;
-            std::swap(addr_queue,empty);
-            offset_buff.clear();
+            //Um flush de uma thread ("F lo hi") mantem os enderecos das demais
+            queue<addr_node> kept;
+            bool front_flushed = !addr_queue.empty() && flush_hits(p,addr_queue.front().rob_pos);
+            while(!addr_queue.empty())
+            {
+                if(!flush_hits(p,addr_queue.front().rob_pos))
+                    kept.push(addr_queue.front());
+                addr_queue.pop();
+            }
+            std::swap(addr_queue,kept);
+            if(front_flushed)
+                flush_count++;
+            for(unsigned int i = 0 ; i < offset_buff.size() ; )
+            {
+                if(flush_hits(p,offset_buff[i].rob_pos))
+                    offset_buff.erase(offset_buff.begin() + i);
+                else
+                    i++;
+            }
+            if(flush_hits(p,rob_pos))
+                isFlushed = true;
+            //Instrucao enviada pelo issue antes do flush e ainda nao lida
+            string pend = "";
+            in_issue->nb_read(pend);
+            if(pend != "" && flush_hits(p,std::stoi(instruction_split(pend)[5])))
+                stale_issue = true;
         }
         wait();
     }
@@ -178,7 +237,7 @@ string address_unit::ask_rob_value(string rob_pos)
     string res;
     out_rob_svl->write(rob_pos);
     in_rob_svl->nb_read(res);
-    while(res == "F")
+    while(is_flush(res))
         wait(out_rob->default_event());
     in_rob_svl->notify();
     return res;
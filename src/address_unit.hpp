@@ -43,6 +43,9 @@ private:
 	vector<addr_node> offset_buff;
 	int regst,rg_i,rob_pos,instr_pos,rst_pos;
 	unsigned int a,delay_time;
+	bool isFlushed; //flush ocorreu durante a leitura dos operandos do issue atual
+	bool stale_issue; //instrucao pendente no barramento do issue no momento do flush
+	unsigned int flush_count; //flushes recebidos do ROB
 	sc_event addr_queue_event;
 	nana::listbox::cat_proxy instruct_table;
 	nana::listbox::cat_proxy res_station_table;
@@ -52,5 +55,6 @@ private:
 	float ask_value(string reg);
 	unsigned int ask_status(bool read,string reg,unsigned int pos = 0);
 	void check_loads();
+	void wait_issue();
 	string ask_rob_value(string rob_pos);
 };
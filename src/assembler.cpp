@@ -0,0 +1,359 @@
+#include "assembler.hpp"
+#include<cctype>
+#include<algorithm>
+
+assembler::assembler()
+{
+    //Operandos de cada instrucao: r registrador, i imediato, m memoria
+    //"off(Rs)" e b alvo de desvio. Novas instrucoes devem ser adicionadas aqui
+    formats = {{"DADD","rrr"},{"DADDU","rrr"},{"DSUB","rrr"},{"DSUBU","rrr"},
+               {"DMUL","rrr"},{"DMULU","rrr"},{"DDIV","rrr"},{"DDIVU","rrr"},
+               {"SLT","rrr"},{"SGT","rrr"},{"MOVZ","rrr"},{"MOVN","rrr"},
+               {"DADDI","rri"},{"DADDIU","rri"},{"DFMA","rrrr"},
+               {"ADDV","rrr"},{"SUBV","rrr"},{"MULV","rrr"},{"SEQV","rrr"},{"SUMV","rr"},
+               {"LD","rm"},{"SD","rm"},{"LLD","rm"},{"SCD","rm"},{"SDNT","rm"},
+               {"LV","rm"},{"SV","rm"},{"PREF","im"},{"SYNC",""},
+               {"BEQ","rrb"},{"BNE","rrb"},{"BGTZ","rb"},{"BLTZ","rb"},
+               {"BGEZ","rb"},{"BLEZ","rb"},{"LOOP","rb"},{"J","b"}};
+}
+
+bool assembler::assemble(std::istream &src)
+{
+    symbols.clear();
+    labels.clear();
+    lines.clear();
+    program.clear();
+    data.clear();
+    errors.clear();
+    first_pass(src);
+    second_pass();
+    //Erros das duas passagens na ordem das linhas
+    std::stable_sort(errors.begin(),errors.end(),[](const string &a, const string &b)
+    {
+        return std::stoi(a.substr(6)) < std::stoi(b.substr(6));
+    });
+    return errors.empty();
+}
+
+const vector<string> &assembler::get_program()
+{
+    return program;
+}
+
+const vector<int> &assembler::get_data()
+{
+    return data;
+}
+
+const vector<string> &assembler::get_errors()
+{
+    return errors;
+}
+
+void assembler::error(unsigned int line, string msg)
+{
+    errors.push_back("linha " + std::to_string(line) + ": " + msg);
+}
+
+//Define os simbolos e guarda as instrucoes e os .word para a segunda passagem
+void assembler::first_pass(std::istream &src)
+{
+    string raw;
+    unsigned int n = 0;
+    int section = SEC_TEXT;
+    unsigned int text_pos = 0,data_pos = 0,data_size = 0;
+    while(getline(src,raw))
+    {
+        n++;
+        size_t cut = std::min(raw.find("//"),raw.find('#'));
+        string s = trim(raw.substr(0,cut == string::npos ? raw.size() : cut));
+        //Rotulos no inicio da linha, seguidos ou nao de uma instrucao
+        size_t colon;
+        while((colon = s.find(':')) != string::npos && is_symbol(trim(s.substr(0,colon))))
+        {
+            string name = trim(s.substr(0,colon));
+            if(symbols.count(name))
+                error(n,"simbolo " + name + " redefinido");
+            else if(section == SEC_DATA)
+                symbols[name] = {(int)data_pos,false};
+            else
+            {
+                symbols[name] = {(int)text_pos,true};
+                labels[text_pos].push_back(name);
+            }
+            s = trim(s.substr(colon+1));
+        }
+        if(s.empty())
+            continue;
+        size_t sp = s.find_first_of(" \t");
+        string name = s.substr(0,sp);
+        string op = upper(name);
+        vector<string> operands;
+        string rest = sp == string::npos ? "" : trim(s.substr(sp));
+        size_t start = 0,comma;
+        while(!rest.empty())
+        {
+            comma = rest.find(',',start);
+            operands.push_back(trim(rest.substr(start,comma == string::npos ? string::npos : comma-start)));
+            if(comma == string::npos)
+                break;
+            start = comma+1;
+        }
+        int value;
+        bool text;
+        if(op == ".TEXT")
+            section = SEC_TEXT;
+        else if(op == ".DATA")
+        {
+            section = SEC_DATA;
+            if(operands.size() == 1 && eval(operands[0],n,value,text))
+            {
+                if(value < 0)
+                    error(n,"endereco negativo na secao .data");
+                else
+                    data_pos = value;
+            }
+        }
+        else if(op == ".EQU")
+        {
+            if(operands.size() != 2 || !is_symbol(operands[0]))
+                error(n,".equ espera um nome e um valor");
+            else if(symbols.count(operands[0]))
+                error(n,"simbolo " + operands[0] + " redefinido");
+            else if(eval(operands[1],n,value,text))
+                symbols[operands[0]] = {value,text};
+        }
+        else if(op == ".WORD" || op == ".SPACE")
+        {
+            if(section != SEC_DATA)
+                error(n,name + " fora da secao .data");
+            else if(operands.empty())
+                error(n,name + " sem valores");
+            else if(op == ".WORD")
+            {
+                lines.push_back({n,SEC_DATA,op,operands,data_pos});
+                data_pos += operands.size();
+            }
+            else if(operands.size() != 1)
+                error(n,".space espera o numero de palavras");
+            else if(eval(operands[0],n,value,text))
+            {
+                if(value < 0)
+                    error(n,".space com tamanho negativo");
+                else
+                    data_pos += value;
+            }
+        }
+        else if(op.at(0) == '.')
+            error(n,"diretiva " + name + " desconhecida");
+        else if(section != SEC_TEXT)
+            error(n,"instrucao " + name + " fora da secao .text");
+        else
+        {
+            if(!formats.count(op))
+                error(n,"instrucao " + name + " desconhecida");
+            else
+                lines.push_back({n,SEC_TEXT,op,operands,text_pos});
+            //Conta mesmo com erro, para os rotulos seguintes continuarem certos
+            text_pos++;
+        }
+        data_size = std::max(data_size,data_pos);
+    }
+    if(data_size)
+        data.assign(data_size,0);
+}
+
+//Gera as instrucoes e os dados com todos os simbolos ja definidos
+void assembler::second_pass()
+{
+    int value;
+    bool text;
+    for(unsigned int l = 0 ; l < lines.size() ; l++)
+    {
+        source_line &sl = lines[l];
+        if(sl.section == SEC_DATA)
+        {
+            for(unsigned int k = 0 ; k < sl.operands.size() ; k++)
+                if(eval(sl.operands[k],sl.line,value,text))
+                    data[sl.pos+k] = value;
+            continue;
+        }
+        string fmt = formats[sl.op];
+        if(sl.operands.size() != fmt.size())
+        {
+            error(sl.line,sl.op + " espera " + std::to_string(fmt.size()) + " operandos");
+            continue;
+        }
+        string out = sl.op;
+        for(unsigned int k = 0 ; k < fmt.size() ; k++)
+        {
+            string o = sl.operands[k];
+            string res;
+            if(fmt[k] == 'r')
+            {
+                res = upper(o);
+                if(!is_register(res))
+                    error(sl.line,"registrador " + o + " invalido");
+            }
+            else if(fmt[k] == 'm')
+            {
+                size_t par = o.find('(');
+                if(par == string::npos || o.back() != ')')
+                {
+                    error(sl.line,"operando de memoria " + o + " invalido, esperado off(Rs)");
+                    continue;
+                }
+                string reg = upper(trim(o.substr(par+1,o.size()-par-2)));
+                string off = trim(o.substr(0,par));
+                value = 0;
+                if(!is_register(reg))
+                    error(sl.line,"registrador " + reg + " invalido");
+                else if(off.empty() || eval(off,sl.line,value,text))
+                    res = std::to_string(value) + "(" + reg + ")";
+            }
+            else if(eval(o,sl.line,value,text))
+            {
+                //Rotulo do codigo como alvo: deslocamento relativo a instrucao
+                if(fmt[k] == 'b' && text)
+                    value -= sl.pos;
+                res = std::to_string(value);
+            }
+            out += (k == 0 ? " " : ",") + res;
+        }
+        if(program.size() < sl.pos)
+            program.resize(sl.pos);
+        program.push_back(out);
+    }
+}
+
+bool assembler::eval(string expr, unsigned int line, int &value, bool &text)
+{
+    expr = trim(expr);
+    value = 0;
+    text = false;
+    int sign = 1;
+    size_t i = 0;
+    if(expr.empty())
+    {
+        error(line,"operando vazio");
+        return false;
+    }
+    while(true)
+    {
+        while(i < expr.size() && isspace(expr[i]))
+            i++;
+        if(i < expr.size() && (expr[i] == '+' || expr[i] == '-'))
+        {
+            sign *= expr[i] == '-' ? -1 : 1;
+            i++;
+        }
+        size_t j = i;
+        while(j < expr.size() && (isalnum(expr[j]) || expr[j] == '_' || expr[j] == '.'))
+            j++;
+        string token = expr.substr(i,j-i);
+        if(token.empty())
+        {
+            error(line,"expressao " + expr + " invalida");
+            return false;
+        }
+        if(isdigit(token[0]))
+        {
+            bool hex = token.size() > 2 && token[0] == '0' && (token[1] == 'x' || token[1] == 'X');
+            size_t used = 0;
+            long v = 0;
+            try
+            {
+                v = std::stol(hex ? token.substr(2) : token,&used,hex ? 16 : 10);
+            }
+            catch(...)
+            {
+                used = 0;
+            }
+            if(used != (hex ? token.size()-2 : token.size()))
+            {
+                error(line,"numero " + token + " invalido");
+                return false;
+            }
+            value += sign*v;
+        }
+        else
+        {
+            auto it = symbols.find(token);
+            if(it == symbols.end())
+            {
+                error(line,"simbolo " + token + " nao definido");
+                return false;
+            }
+            value += sign*it->second.value;
+            text = text || it->second.text;
+        }
+        i = j;
+        while(i < expr.size() && isspace(expr[i]))
+            i++;
+        if(i == expr.size())
+            return true;
+        if(expr[i] != '+' && expr[i] != '-')
+        {
+            error(line,"expressao " + expr + " invalida");
+            return false;
+        }
+        sign = expr[i] == '-' ? -1 : 1;
+        i++;
+    }
+}
+
+bool assembler::is_register(string reg)
+{
+    if(reg.size() < 2 || reg.size() > 3 || (reg[0] != 'R' && reg[0] != 'F' && reg[0] != 'V'))
+        return false;
+    for(unsigned int i = 1 ; i < reg.size() ; i++)
+        if(!isdigit(reg[i]))
+            return false;
+    return std::stoi(reg.substr(1)) < 32;
+}
+
+bool assembler::is_symbol(string name)
+{
+    if(name.empty() || !(isalpha(name[0]) || name[0] == '_'))
+        return false;
+    for(unsigned int i = 0 ; i < name.size() ; i++)
+        if(!isalnum(name[i]) && name[i] != '_' && name[i] != '.')
+            return false;
+    //Nomes de registradores nao podem ser simbolos
+    return !is_register(upper(name));
+}
+
+void assembler::write_program(std::ostream &out)
+{
+    for(unsigned int i = 0 ; i <= program.size() ; i++)
+    {
+        if(labels.count(i))
+            for(unsigned int k = 0 ; k < labels[i].size() ; k++)
+                out << "// " << labels[i][k] << ":" << std::endl;
+        if(i < program.size())
+            out << program[i] << std::endl;
+    }
+}
+
+void assembler::write_memory(std::ostream &out)
+{
+    for(unsigned int i = 0 ; i < data.size() ; i++)
+        out << (i ? " " : "") << data[i];
+    out << std::endl;
+}
+
+string assembler::trim(string s)
+{
+    size_t b = s.find_first_not_of(" \t\r");
+    if(b == string::npos)
+        return "";
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b,e-b+1);
+}
+
+string assembler::upper(string s)
+{
+    for(unsigned int i = 0 ; i < s.size() ; i++)
+        s[i] = toupper(s[i]);
+    return s;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<map>
+#include<istream>
+#include<ostream>
+
+using std::vector;
+using std::string;
+using std::map;
+
+// Montador de duas passagens para os programas do simulador. A fonte tem
+// rotulos ("nome:"), as secoes .text e .data, constantes (.equ NOME,valor) e
+// dados (.word v1,v2,... e .space n), com comentarios iniciados por "//" ou
+// "#". Nos desvios, no J e no LOOP o alvo pode ser um rotulo do codigo, que
+// vira o deslocamento relativo usado pela fila (alvo - pc); nos demais
+// operandos numericos um simbolo vale o endereco do dado, o valor da
+// constante ou o indice da instrucao, e aceita "simbolo+n" e "simbolo-n".
+// A primeira passagem define os simbolos e o tamanho das secoes, a segunda
+// gera as instrucoes ja resolvidas (no formato lido pela fila de instrucoes)
+// e a imagem da memoria. Os erros sao acumulados com o numero da linha.
+class assembler
+{
+public:
+    assembler();
+    // Monta a fonte; retorna false se houve algum erro
+    bool assemble(std::istream &src);
+    const vector<string> &get_program();
+    // Imagem da memoria a partir do endereco 0 (vazia sem secao .data)
+    const vector<int> &get_data();
+    // Mensagens "linha N: ..."
+    const vector<string> &get_errors();
+    // Programa montado no formato da fila (-q), com os rotulos em comentarios
+    void write_program(std::ostream &out);
+    // Imagem da memoria no formato dos arquivos de memoria (-m)
+    void write_memory(std::ostream &out);
+
+private:
+    enum { SEC_NONE, SEC_TEXT, SEC_DATA };
+    struct source_line
+    {
+        unsigned int line; //numero da linha na fonte
+        int section;
+        string op; //mnemonico ou diretiva, em maiusculas
+        vector<string> operands;
+        unsigned int pos; //indice da instrucao ou endereco do dado
+    };
+    struct symbol
+    {
+        int value;
+        bool text; //rotulo de instrucao
+    };
+    map<string,string> formats; //operandos de cada instrucao
+    map<string,symbol> symbols;
+    map<unsigned int,vector<string>> labels; //rotulos de cada instrucao
+    vector<source_line> lines;
+    vector<string> program;
+    vector<int> data;
+    vector<string> errors;
+
+    void first_pass(std::istream &src);
+    void second_pass();
+    void error(unsigned int line, string msg);
+    // Valor de "n", "simbolo" ou "simbolo+n"/"simbolo-n"; text indica um
+    // rotulo de instrucao na expressao
+    bool eval(string expr, unsigned int line, int &value, bool &text);
+    static bool is_register(string reg);
+    static bool is_symbol(string name);
+    static string trim(string s);
+    static string upper(string s);
+};
@@ -14,6 +14,10 @@ bool bpb::bpb_predict(unsigned int pc){
     return (bp_buffer[pc % size]&msb);
 }
 
+bool bpb::bpb_peek(unsigned int pc){
+    return (bp_buffer[pc % size]&msb);
+}
+
 void bpb::bpb_update_state(unsigned int pc, bool taken, bool hit){
     int i = pc % size;
     int state_aux = bp_buffer[i];
@@ -8,6 +8,8 @@ class bpb {
 public:
     bpb(unsigned int t, unsigned int z);
     bool bpb_predict(unsigned int pc);
+    // Predicao sem contar nas estatisticas (busca antecipada da FTQ)
+    bool bpb_peek(unsigned int pc);
     void bpb_update_state(unsigned int pc, bool taken, bool hit);
     float bpb_get_hit_rate();
     int get_bpb_size();
@@ -3,6 +3,8 @@ class branch_predictor
 public:
     branch_predictor(unsigned int t);
     bool predict();
+    // Predicao sem contar nas estatisticas (busca antecipada da FTQ)
+    bool peek();
     void update_state(bool taken, bool hit);
     float get_predictor_hit_rate();
     
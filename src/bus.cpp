@@ -1,19 +1,100 @@
 #include "bus.hpp"
+#include<algorithm>
         
 bus::bus(sc_module_name name): sc_channel(name)
 {
-    stamp = sc_time(-1,SC_NS);
+    written = requested = false;
+    arbitration = false;
+    best_prio = prio_wins = 0;
+    tickets = best_ticket = first_ticket = req_count = 0;
 }
 void bus::write(string p)
 {
+    if(arbitration)
+    {
+        write(p,0);
+        return;
+    }
     string p_back = p;
-    while(sc_time_stamp() == stamp)
+    while(written && sc_time_stamp() == stamp)
         wait(sc_time(1,SC_NS));
     stamp = sc_time_stamp();
+    written = true;
+    wait(SC_ZERO_TIME);
+    palavra = p_back;
+    write_event.notify();
+}
+void bus::write(string p, unsigned int prio)
+{
+    if(!arbitration)
+    {
+        write(p);
+        return;
+    }
+    string p_back = p;
+    //Ordem de chegada: desempata a prioridade e mostra se a escrita passou
+    //na frente de outra mais antiga
+    unsigned int ticket = tickets++;
+    bool registered = false;
+    sc_time mine;
+    while(true)
+    {
+        while(written && sc_time_stamp() == stamp)
+            wait(sc_time(1,SC_NS));
+        if(!registered || mine != sc_time_stamp())
+        {
+            registered = true;
+            mine = sc_time_stamp();
+            if(!requested || req_stamp != sc_time_stamp())
+            {
+                requested = true;
+                req_stamp = sc_time_stamp();
+                best_prio = prio;
+                best_ticket = first_ticket = ticket;
+            }
+            else
+            {
+                if(prio > best_prio || (prio == best_prio && ticket < best_ticket))
+                {
+                    best_prio = prio;
+                    best_ticket = ticket;
+                }
+                first_ticket = std::min(first_ticket,ticket);
+            }
+            req_count++;
+        }
+        // Os pedidos do ciclo chegam em deltas diferentes; decide so depois
+        // de um delta sem pedidos novos, para que todos disputem
+        unsigned int seen;
+        do
+        {
+            seen = req_count;
+            wait(SC_ZERO_TIME);
+        }
+        while(seen != req_count);
+        if(ticket == best_ticket && (!written || sc_time_stamp() != stamp))
+            break;
+    }
+    if(ticket != first_ticket)
+        prio_wins++;
+    stamp = sc_time_stamp();
+    written = true;
     wait(SC_ZERO_TIME);
     palavra = p_back;
     write_event.notify();
 }
+void bus::set_arbitration(bool a)
+{
+    arbitration = a;
+}
+bool bus::get_arbitration()
+{
+    return arbitration;
+}
+unsigned int bus::get_prio_wins()
+{
+    return prio_wins;
+}
 const sc_event& bus::default_event() const
 {
     return write_event;
@@ -74,7 +155,8 @@ cons_bus_fast::cons_bus_fast(sc_module_name name): sc_channel(name)
 }
 void cons_bus_fast::write(string p)
 {
-    if(!empty)
+    //Outro escritor pode ocupar o barramento na mesma notificacao de leitura
+    while(!empty)
         wait(read_event);
     empty = false;
     palavra = p;
@@ -1,18 +1,31 @@
 #pragma once
 #include "interfaces.hpp"
 
-class bus: public sc_channel, public write_if, public read_if
+class bus: public sc_channel, public prio_write_if, public read_if
 {
 public:
     bus(sc_module_name name);
     void write(string p);
+    void write(string p, unsigned int prio);
     const sc_event& default_event() const;
     void read(string &p);
+    // Liga a arbitragem por prioridade entre escritas do mesmo ciclo
+    void set_arbitration(bool a);
+    bool get_arbitration();
+    unsigned int get_prio_wins();
 
 private:
     string palavra;
     sc_event write_event;
-    sc_time stamp;
+    sc_time stamp; //ciclo da ultima escrita, valido se written
+    bool written,requested;
+    bool arbitration;
+    sc_time req_stamp; //ciclo dos pedidos em disputa, valido se requested
+    unsigned int best_prio,prio_wins;
+    unsigned int tickets; //pedidos ja recebidos, numera cada escrita
+    unsigned int best_ticket,first_ticket; //vencedor e pedido mais antigo do ciclo
+    unsigned int req_count; //muda a cada pedido novo
+
 };
 
 class cons_bus: public sc_channel, public write_if_f, public read_if_f
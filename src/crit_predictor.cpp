@@ -0,0 +1,41 @@
+#include "crit_predictor.hpp"
+
+crit_predictor::crit_predictor(unsigned int t): table(t ? t : 1,0)
+{
+    updates = 0;
+    critical_updates = 0;
+}
+
+bool crit_predictor::predict(unsigned int pc)
+{
+    return table[pc%table.size()] >= 2;
+}
+
+void crit_predictor::update_state(unsigned int pc, bool critical)
+{
+    unsigned char &state = table[pc%table.size()];
+    updates++;
+    if(critical)
+    {
+        critical_updates++;
+        if(state < 3)
+            state++;
+    }
+    else if(state)
+        state--;
+}
+
+unsigned int crit_predictor::get_size()
+{
+    return table.size();
+}
+
+unsigned int crit_predictor::get_updates()
+{
+    return updates;
+}
+
+unsigned int crit_predictor::get_critical_updates()
+{
+    return critical_updates;
+}
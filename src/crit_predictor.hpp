@@ -0,0 +1,22 @@
+#pragma once
+#include<vector>
+
+using std::vector;
+
+// Preditor de criticidade indexado pelo PC (heuristica do ultimo a chegar):
+// a instrucao cujo resultado e o ultimo operando que falta a uma estacao
+// esta no caminho critico dela. Cada entrada e um contador saturante de 2 bits.
+class crit_predictor
+{
+public:
+    crit_predictor(unsigned int t);
+    bool predict(unsigned int pc);
+    void update_state(unsigned int pc, bool critical);
+    unsigned int get_size();
+    unsigned int get_updates();
+    unsigned int get_critical_updates();
+
+private:
+    vector<unsigned char> table;
+    unsigned int updates,critical_updates;
+};
@@ -0,0 +1,334 @@
+#include "data_cache.hpp"
+
+data_cache::data_cache(unsigned int lines, unsigned int block, unsigned int miss_latency):
+table(lines,{false,0,SC_ZERO_TIME,PF_NONE,MESI_I}),
+block_size(block ? block : 1),
+miss_latency(miss_latency)
+{
+    hits = misses = merged = 0;
+    prefetches = useful_prefetches = 0;
+    sw_prefetches = sw_dropped = sw_useful = sw_unused = 0;
+    stream_stores = 0;
+    bus = NULL;
+    core = 0;
+    store_hits = store_misses = 0;
+    invalidations = writebacks = 0;
+    link_breaks = 0;
+}
+
+bool data_cache::enabled()
+{
+    return !table.empty();
+}
+
+void data_cache::set_coherence(snoop_bus *b)
+{
+    bus = b;
+    core = bus->attach(this);
+}
+
+bool data_cache::coherent()
+{
+    return bus != NULL && enabled();
+}
+
+data_cache::cache_line &data_cache::line(unsigned int addr)
+{
+    return table[(addr/block_size)%table.size()];
+}
+
+unsigned int data_cache::access(unsigned int addr, sc_time now)
+{
+    if(!enabled())
+        return 0;
+    cache_line &l = line(addr);
+    if(l.valid && l.block == addr/block_size)
+    {
+        if(l.prefetched != PF_NONE)
+        {
+            if(l.prefetched == PF_SW)
+                sw_useful++;
+            else
+                useful_prefetches++;
+            l.prefetched = PF_NONE;
+        }
+        if(l.fill <= now)
+        {
+            hits++;
+            return 0;
+        }
+        merged++;
+        return (l.fill - now).value() / 1000;
+    }
+    misses++;
+    evict(l);
+    if(coherent())
+    {
+        l.fill = bus_fill(l,addr/block_size,snoop_bus::BUS_RD,now);
+        l.prefetched = PF_NONE;
+        return (l.fill - now).value() / 1000;
+    }
+    l = {true,addr/block_size,now + sc_time(miss_latency,SC_NS),PF_NONE};
+    return miss_latency;
+}
+
+void data_cache::prefetch(unsigned int addr, sc_time now, bool software)
+{
+    if(!enabled())
+        return;
+    if(present(addr))
+    {
+        if(software)
+            sw_dropped++;
+        return;
+    }
+    cache_line &l = line(addr);
+    int source = software ? PF_SW : PF_HW;
+    if(software)
+        sw_prefetches++;
+    else
+        prefetches++;
+    evict(l);
+    if(coherent())
+    {
+        l.fill = bus_fill(l,addr/block_size,snoop_bus::BUS_RD,now);
+        l.prefetched = source;
+        return;
+    }
+    l = {true,addr/block_size,now + sc_time(miss_latency,SC_NS),source};
+}
+
+void data_cache::write(unsigned int addr, sc_time now)
+{
+    break_links(addr/block_size);
+    if(!coherent())
+        return;
+    cache_line &l = line(addr);
+    bool shared;
+    if(l.valid && l.block == addr/block_size)
+    {
+        store_hits++;
+        //S precisa invalidar as outras copias; E passa a M sem transacao
+        if(l.state == MESI_S)
+            bus->transaction(core,snoop_bus::BUS_UPGR,l.block,now,shared);
+        l.state = MESI_M;
+        return;
+    }
+    store_misses++;
+    evict(l);
+    l.fill = bus_fill(l,addr/block_size,snoop_bus::BUS_RDX,now);
+    l.prefetched = PF_NONE;
+}
+
+void data_cache::write_stream(unsigned int addr, sc_time now)
+{
+    break_links(addr/block_size);
+    stream_stores++;
+    if(!enabled())
+        return;
+    cache_line &l = line(addr);
+    bool own = l.valid && l.block == addr/block_size;
+    bool shared;
+    if(coherent())
+    {
+        //Copia modificada volta para a memoria antes de sair da cache; sem
+        //copia exclusiva as outras caches sao invalidadas (sem buscar o bloco)
+        if(own && l.state == MESI_M)
+        {
+            writebacks++;
+            bus->transaction(core,snoop_bus::BUS_WB,l.block,now,shared);
+        }
+        else if(!own || l.state == MESI_S)
+            bus->transaction(core,snoop_bus::BUS_UPGR,addr/block_size,now,shared);
+    }
+    if(own)
+    {
+        evict(l);
+        l.valid = false;
+        l.state = MESI_I;
+        l.prefetched = PF_NONE;
+    }
+}
+
+void data_cache::evict(cache_line &l)
+{
+    if(l.valid && l.prefetched == PF_SW)
+        sw_unused++;
+}
+
+bool data_cache::snoop(int type, unsigned int block)
+{
+    if(!enabled())
+        return false;
+    //Escrita de outro nucleo desfaz as reservas mesmo sem copia da linha
+    if(type != snoop_bus::BUS_RD)
+        break_links(block);
+    cache_line &l = table[block%table.size()];
+    if(!l.valid || l.block != block)
+        return false;
+    //Copia modificada volta para a memoria junto com a transacao
+    if(l.state == MESI_M)
+        writebacks++;
+    if(type == snoop_bus::BUS_RD)
+        l.state = MESI_S;
+    else
+    {
+        l.valid = false;
+        l.state = MESI_I;
+        invalidations++;
+    }
+    return true;
+}
+
+sc_time data_cache::bus_fill(cache_line &l, unsigned int block, int type, sc_time now)
+{
+    bool shared;
+    //Linha modificada substituida e escrita de volta antes do pedido
+    if(l.valid && l.state == MESI_M)
+    {
+        writebacks++;
+        bus->transaction(core,snoop_bus::BUS_WB,l.block,now,shared);
+    }
+    sc_time end = bus->transaction(core,type,block,now,shared);
+    l.valid = true;
+    l.block = block;
+    if(type == snoop_bus::BUS_RDX)
+        l.state = MESI_M;
+    else
+        l.state = shared ? MESI_S : MESI_E;
+    if(shared)
+        return end;
+    return end + sc_time(miss_latency,SC_NS);
+}
+
+void data_cache::link(unsigned int owner, unsigned int addr)
+{
+    links[owner] = addr/block_size;
+}
+
+bool data_cache::check_link(unsigned int owner, unsigned int addr)
+{
+    auto it = links.find(owner);
+    if(it == links.end())
+        return false;
+    bool ok = it->second == addr/block_size && (!coherent() || present(addr));
+    links.erase(it);
+    return ok;
+}
+
+void data_cache::break_links(unsigned int block)
+{
+    for(auto it = links.begin() ; it != links.end() ; )
+    {
+        if(it->second == block)
+        {
+            link_breaks++;
+            it = links.erase(it);
+        }
+        else
+            it++;
+    }
+}
+
+bool data_cache::present(unsigned int addr)
+{
+    if(!enabled())
+        return true;
+    cache_line &l = line(addr);
+    return l.valid && l.block == addr/block_size;
+}
+
+bool data_cache::ready(unsigned int addr, sc_time now)
+{
+    return present(addr) && (!enabled() || line(addr).fill <= now);
+}
+
+unsigned int data_cache::get_lines()
+{
+    return table.size();
+}
+
+unsigned int data_cache::get_block()
+{
+    return block_size;
+}
+
+unsigned int data_cache::get_miss_latency()
+{
+    return miss_latency;
+}
+
+unsigned int data_cache::get_hits()
+{
+    return hits;
+}
+
+unsigned int data_cache::get_misses()
+{
+    return misses;
+}
+
+unsigned int data_cache::get_merged()
+{
+    return merged;
+}
+
+unsigned int data_cache::get_prefetches()
+{
+    return prefetches;
+}
+
+unsigned int data_cache::get_useful_prefetches()
+{
+    return useful_prefetches;
+}
+
+unsigned int data_cache::get_sw_prefetches()
+{
+    return sw_prefetches;
+}
+
+unsigned int data_cache::get_sw_dropped()
+{
+    return sw_dropped;
+}
+
+unsigned int data_cache::get_sw_useful()
+{
+    return sw_useful;
+}
+
+unsigned int data_cache::get_sw_unused()
+{
+    return sw_unused;
+}
+
+unsigned int data_cache::get_stream_stores()
+{
+    return stream_stores;
+}
+
+unsigned int data_cache::get_store_hits()
+{
+    return store_hits;
+}
+
+unsigned int data_cache::get_store_misses()
+{
+    return store_misses;
+}
+
+unsigned int data_cache::get_invalidations()
+{
+    return invalidations;
+}
+
+unsigned int data_cache::get_writebacks()
+{
+    return writebacks;
+}
+
+unsigned int data_cache::get_link_breaks()
+{
+    return link_breaks;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include<vector>
+#include<map>
+#include<systemc.h>
+#include "snoop_bus.hpp"
+
+using std::vector;
+using std::map;
+
+// Cache de dados mapeada diretamente que da latencia aos loads do modo com
+// especulacao. Os misses nao bloqueiam: cada linha guarda o instante em que
+// o seu preenchimento termina, e um acesso a uma linha ainda em preenchimento
+// espera so o restante (miss secundario, como em um MSHR). Os stores escrevem
+// direto na memoria sem alocar linha (write-through, no-allocate).
+// Os prefetches (do runahead ou do PREF do programa) preenchem a linha sem
+// entregar dado; a cache conta quantos foram usados por um load antes de a
+// linha ser substituida. O store nao temporal (SDNT) nunca aloca linha e
+// invalida a copia desta cache.
+// Com 0 linhas a cache fica desligada e todo acesso e um acerto.
+// No modo multicore a cache fica ligada a um snoop_bus e as linhas tem estado
+// MESI: os misses pedem o bloco pelo barramento e os stores alocam a linha em
+// M (write-back, write-allocate), invalidando as copias das outras caches.
+// O valor continua lido e escrito na memoria unica; a cache so da a latencia.
+// A cache tambem guarda as reservas do LLD (uma por thread): qualquer store
+// no bloco reservado, deste ou de outro nucleo, desfaz a reserva, e no modo
+// coerente a reserva tambem se perde junto com a linha.
+class data_cache
+{
+public:
+    enum { MESI_I, MESI_S, MESI_E, MESI_M };
+    enum { PF_NONE, PF_HW, PF_SW };
+
+    data_cache(unsigned int lines = 0, unsigned int block = 4, unsigned int miss_latency = 20);
+    bool enabled();
+    // Liga a cache ao barramento coerente do modo multicore
+    void set_coherence(snoop_bus *bus);
+    bool coherent();
+    // Ciclos ate o dado do load em addr ficar disponivel, a partir de now
+    unsigned int access(unsigned int addr, sc_time now);
+    // Inicia o preenchimento da linha de addr se ela estiver ausente.
+    // software: pedido por um PREF do programa, e nao pelo runahead
+    void prefetch(unsigned int addr, sc_time now, bool software = false);
+    // Linha de addr presente, mesmo que ainda em preenchimento
+    bool present(unsigned int addr);
+    // Linha de addr presente e ja preenchida
+    bool ready(unsigned int addr, sc_time now);
+    // Store no commit: desfaz as reservas do bloco e obtem a linha em M (so no modo coerente)
+    void write(unsigned int addr, sc_time now);
+    // Store nao temporal no commit: escreve sem alocar a linha e invalida as
+    // copias, a desta cache inclusive (no modo coerente sem buscar o bloco)
+    void write_stream(unsigned int addr, sc_time now);
+    // LLD da thread owner reserva o bloco de addr
+    void link(unsigned int owner, unsigned int addr);
+    // SCD da thread owner: retorna se a reserva no bloco de addr continua valida
+    // e a consome
+    bool check_link(unsigned int owner, unsigned int addr);
+    // Transacao de outro nucleo no barramento; retorna se havia copia do bloco
+    bool snoop(int type, unsigned int block);
+    unsigned int get_lines();
+    unsigned int get_block();
+    unsigned int get_miss_latency();
+    unsigned int get_hits();
+    unsigned int get_misses();
+    unsigned int get_merged();
+    unsigned int get_prefetches();
+    unsigned int get_useful_prefetches();
+    // PREF: linhas pedidas, descartados com a linha ja presente, usados por
+    // loads e substituidos antes de qualquer uso
+    unsigned int get_sw_prefetches();
+    unsigned int get_sw_dropped();
+    unsigned int get_sw_useful();
+    unsigned int get_sw_unused();
+    unsigned int get_stream_stores();
+    unsigned int get_store_hits();
+    unsigned int get_store_misses();
+    unsigned int get_invalidations();
+    unsigned int get_writebacks();
+    unsigned int get_link_breaks();
+
+private:
+    struct cache_line
+    {
+        bool valid;
+        unsigned int block; //numero do bloco de memoria na linha
+        sc_time fill; //instante em que o preenchimento termina
+        int prefetched; //origem do prefetch que trouxe a linha (PF_HW ou PF_SW), ainda nao usada por um load
+        int state; //estado MESI, so no modo coerente
+    };
+    vector<cache_line> table;
+    unsigned int block_size,miss_latency;
+    unsigned int hits,misses,merged;
+    unsigned int prefetches,useful_prefetches;
+    unsigned int sw_prefetches,sw_dropped,sw_useful,sw_unused;
+    unsigned int stream_stores;
+    snoop_bus *bus;
+    unsigned int core;
+    unsigned int store_hits,store_misses;
+    unsigned int invalidations,writebacks;
+    map<unsigned int,unsigned int> links; //bloco reservado por thread
+    unsigned int link_breaks; //reservas desfeitas por stores
+
+    // Desfaz as reservas no bloco
+    void break_links(unsigned int block);
+
+    cache_line &line(unsigned int addr);
+    // Linha l vai ser substituida: conta o prefetch do PREF que nao foi usado
+    void evict(cache_line &l);
+    // Traz o bloco para a linha l pelo barramento; retorna o fim do preenchimento
+    sc_time bus_fill(cache_line &l, unsigned int block, int type, sc_time now);
+};
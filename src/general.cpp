@@ -14,3 +14,51 @@ vector<string> instruction_split(string p)
     ord.push_back(p.substr(last_pos,p.size()-last_pos));
     return ord;
 }
+
+bool is_flush(string p)
+{
+    return p != "" && p[0] == 'F';
+}
+
+bool flush_hits(string p, unsigned int rob_pos)
+{
+    if(!is_flush(p))
+        return false;
+    if(p == "F")
+        return true;
+    vector<string> ord = instruction_split(p);
+    return rob_pos >= (unsigned int)std::stoi(ord[1]) && rob_pos <= (unsigned int)std::stoi(ord[2]);
+}
+
+bool is_vector_op(string op)
+{
+    return op == "LV" || op == "SV" || op == "ADDV" || op == "SUBV" || op == "MULV" || op == "SEQV" || op == "SUMV";
+}
+
+vector<int> lanes_split(string p, unsigned int n)
+{
+    vector<int> lanes;
+    size_t start = 0;
+    while(lanes.size() < n && start < p.size())
+    {
+        size_t end = p.find(':',start);
+        if(end == string::npos)
+            end = p.size();
+        lanes.push_back(end > start ? (int)std::stof(p.substr(start,end-start)) : 0);
+        start = end+1;
+    }
+    lanes.resize(n,0);
+    return lanes;
+}
+
+string lanes_join(vector<int> lanes)
+{
+    string res;
+    for(unsigned int i = 0 ; i < lanes.size() ; i++)
+    {
+        if(i)
+            res += ':';
+        res += std::to_string(lanes[i]);
+    }
+    return res;
+}
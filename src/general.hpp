@@ -31,3 +31,13 @@ enum{
 };
 
 vector<string> instruction_split(string p);
+// Flush do ROB: "F" descarta todas as entradas e "F lo hi" so as entradas
+// de lo a hi (a particao de uma thread no SMT)
+bool is_flush(string p);
+bool flush_hits(string p, unsigned int rob_pos);
+// Instrucoes vetoriais (SIMD) do modo com especulacao
+bool is_vector_op(string op);
+// Valor de um registrador vetorial: elementos inteiros separados por ':'
+// ("1:2:3:4"). lanes_split completa com zeros ate n elementos
+vector<int> lanes_split(string p, unsigned int n);
+string lanes_join(vector<int> lanes);
@@ -10,6 +10,8 @@ using namespace nana;
 
 char const* str_spec = "<vert <weight = 5%><vert weight=85% < <weight = 1% ><instr> <rst> <weight = 1%> <weight = 20% regs> <weight = 1%> > < <weight = 1%> <memor> <weight = 1%> <rob> <weight = 1%> > > < <weight = 1%> <clk_c weight=15%> <weight=25%> <gap = 10btns> <weight = 1%> > <weight = 2%> >";
 
+char const* str_core = "<vert <weight = 2%><vert weight=93% < <weight = 1% ><instr> <rst> <weight = 1%> <weight = 20% regs> <weight = 1%> > < <weight = 1%> <rob> <weight = 1%> <clk_c weight=15%> <weight = 1%> > > >";
+
 char const* str_nospec = "<vert <weight = 5%><vert weight=85% < <weight = 1% ><instr> <weight = 1%> <rst> <weight = 1%> > < <weight = 1%> <memor> <weight = 1%> <weight = 29% regs> <weight = 1%> > > < <weight = 1%> <clk_c weight=15%> <weight=25%> <gap = 10btns> <weight = 1%> > <weight = 2%> >";
 
 // Mostra mensagem na interface grafica
@@ -29,6 +31,74 @@ void set_spec(nana::place &plc, bool is_spec)
     plc.collocate();
 }
 
+// Colunas das tabelas de estacoes, registradores, instrucoes e ROB
+void set_headers(nana::listbox &table, nana::listbox &reg, nana::listbox &instruct, nana::listbox &rob)
+{
+    vector<string> columns = {"#","Name","Busy","Op","Vj","Vk","Qj","Qk","A"}; 
+    vector<int> sizes;
+    for(unsigned int i = 0 ; i < columns.size() ; i++)
+    {
+        table.append_header(columns[i].c_str());
+        if(i && i != 3)
+            table.column_at(i).width(45);
+        else if (i == 3)
+            table.column_at(i).width(60);
+        else
+            table.column_at(i).width(30);
+    }
+    columns = {"","Value","Qi"};
+    sizes = {30,75,40};
+    for(unsigned int k = 0 ; k < 3 ; k++)
+        for(unsigned int i = 0 ; i < columns.size() ; i++)
+        {
+            reg.append_header(columns[i]);
+            reg.column_at(k*columns.size() + i).width(sizes[i]);
+        }
+    columns = {"Instruction","Issue","Execute","Write Result"};
+    sizes = {140,60,70,95};
+    for(unsigned int i = 0 ; i < columns.size() ; i++)
+    {
+        instruct.append_header(columns[i]);
+        instruct.column_at(i).width(sizes[i]);
+    }
+    columns = {"Entry","Busy","Instruction","State","Destination","Value"};
+    sizes = {45,45,120,120,90,60};
+    for(unsigned int i = 0 ; i < columns.size() ; i++)
+    {
+        rob.append_header(columns[i]);
+        rob.column_at(i).width(sizes[i]);
+    }
+}
+
+core_window::core_window(unsigned int id, nana::listbox &regs):
+fm(API::make_center(900,600)),
+plc(fm),
+table(fm),
+reg(fm),
+instruct(fm),
+rob(fm),
+clock_group(fm),
+clock_count(clock_group)
+{
+    fm.caption("TFSim - Nucleo " + std::to_string(id));
+    clock_group.caption("Ciclo");
+    clock_group.div("count");
+    set_headers(table,reg,instruct,rob);
+    auto src = regs.at(0);
+    auto dst = reg.at(0);
+    for(unsigned int i = 0 ; i < src.size() ; i++)
+        dst.append({src.at(i).text(0),src.at(i).text(1),"0",src.at(i).text(3),src.at(i).text(4),"0",src.at(i).text(6),src.at(i).text(7),"0"});
+    plc["rst"] << table;
+    plc["regs"] << reg;
+    plc["rob"] << rob;
+    plc["instr"] << instruct;
+    plc["clk_c"] << clock_group;
+    clock_group["count"] << clock_count;
+    clock_group.collocate();
+    plc.div(str_core);
+    plc.collocate();
+    fm.show();
+}
 
 bool add_instructions(ifstream &File,vector<string> &queue, nana::listbox &instruction_gui)
 {
@@ -52,3 +122,18 @@ bool add_instructions(ifstream &File,vector<string> &queue, nana::listbox &instr
     File.close();
     return true;
 }
+
+void add_instructions(const std::vector<std::string> &program,std::vector<std::string> &queue, nana::listbox &instruction_gui)
+{
+    if(queue.size())
+    {
+        queue.clear();
+        instruction_gui.clear(0);
+    }
+    auto inst_gui_cat = instruction_gui.at(0);
+    for(unsigned int i = 0 ; i < program.size() ; i++)
+    {
+        queue.push_back(program[i]);
+        inst_gui_cat.append(program[i]);
+    }
+}
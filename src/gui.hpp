@@ -2,6 +2,8 @@
 
 #include<nana/gui.hpp>
 #include<nana/gui/widgets/listbox.hpp>
+#include<nana/gui/widgets/label.hpp>
+#include<nana/gui/widgets/group.hpp>
 #include<nana/gui/filebox.hpp>
 #include<fstream>
 #include<vector>
@@ -13,5 +15,21 @@ extern const char*  str_nospec;
 
 
 void set_spec(nana::place &plc, bool is_spec);
+void set_headers(nana::listbox &table, nana::listbox &reg, nana::listbox &instruct, nana::listbox &rob);
 bool add_instructions(std::ifstream &File,std::vector<std::string> &queue, nana::listbox &instruction_gui);
+// Programa ja montado (assembler), sem linhas de comentario
+void add_instructions(const std::vector<std::string> &program,std::vector<std::string> &queue, nana::listbox &instruction_gui);
 void show_message(std::string message_title, std::string message);
+
+// Janela de um nucleo extra do modo multicore, com as tabelas da janela
+// principal e os registradores iniciais copiados de regs
+class core_window
+{
+public:
+    core_window(unsigned int id, nana::listbox &regs);
+    nana::form fm;
+    nana::place plc;
+    nana::listbox table,reg,instruct,rob;
+    nana::group clock_group;
+    nana::label clock_count;
+};
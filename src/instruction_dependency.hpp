@@ -59,6 +59,8 @@ public:
         operand_map["DIV"] = { 1, {2, 3} };
         operand_map["LD"] = { 1, {} };
         operand_map["SD"] = { 0, {1, 3} };
+        operand_map["SDNT"] = { 0, {1, 3} };
+        operand_map["PREF"] = { 0, {} };
 
         // NEW: Double Precision Floating-Point Instructions
         operand_map["DADD"] = { 1, {2, 3} };
@@ -66,11 +68,25 @@ public:
         operand_map["DSUB"] = { 1, {2, 3} };
         operand_map["DMUL"] = { 1, {2, 3} };
         operand_map["DDIV"] = { 1, {2, 3} };
+        operand_map["DFMA"] = { 1, {2, 3, 4} };
+
+        // Conditional Moves (the old destination value is also read)
+        operand_map["MOVZ"] = { 1, {1, 2, 3} };
+        operand_map["MOVN"] = { 1, {1, 2, 3} };
 
         // NEW: Comparison Instructions
         operand_map["SLT"] = { 1, {2, 3} };
         operand_map["SGT"] = { 1, {2, 3} };
 
+        // Vector (SIMD) Instructions
+        operand_map["LV"] = { 1, {} };
+        operand_map["SV"] = { 0, {1, 3} };
+        operand_map["ADDV"] = { 1, {2, 3} };
+        operand_map["SUBV"] = { 1, {2, 3} };
+        operand_map["MULV"] = { 1, {2, 3} };
+        operand_map["SEQV"] = { 1, {2, 3} };
+        operand_map["SUMV"] = { 1, {2} };
+
         // NEW: Branch Instructions (Read-only)
         operand_map["BEQ"] = { 0, {1, 2} }; // No destination register
         operand_map["BNE"] = { 0, {1, 2} }; // No destination register
@@ -20,12 +20,30 @@ void instruction_queue::main()
             cat.at(pc-1).select(false);
         cat.at(pc).select(true,true);
         cat.at(pc).text(ISS,"");
+        //LOOP: resolvida na busca, sem passar pelo issue
+        if(loop_unit::is_loop(instruct_queue[pc]))
+        {
+            unsigned int target;
+            int res;
+            while((res = loops.step(pc,instruct_queue[pc],target)) == loop_unit::LOOP_WAIT)
+                wait();
+            cat.at(pc).text(ISS,"X");
+            if(res == loop_unit::LOOP_TAKEN)
+                pc = target - 1; //o incremento do for leva ao alvo
+            continue;
+        }
+        loops.fetch(pc);
         out->write(instruct_queue[pc] + " " + std::to_string(pc));
         cat.at(pc).text(ISS,"X");
         wait();
     }
 }
 
+void instruction_queue::set_regs(nana::listbox *regs)
+{
+    loops.set_regs(regs);
+}
+
 bool instruction_queue::queue_is_empty() {
 	return instruct_queue.size() == 0;
 }
@@ -1,6 +1,7 @@
 #include<systemc.h>
 #include<vector>
 #include "interfaces.hpp"
+#include "loop_unit.hpp"
 #include<nana/gui/widgets/listbox.hpp>
 
 using std::vector;
@@ -16,9 +17,12 @@ public:
 
 		bool queue_is_empty();
     void main();
+    // Banco de registradores lido pelas instrucoes LOOP
+    void set_regs(nana::listbox *regs);
 
 private:
     unsigned int pc;
     vector<string> instruct_queue;
     nana::listbox &instructions;
+    loop_unit loops;
 };
@@ -1,5 +1,6 @@
 #include "instruction_queue_rob.hpp"
 #include "general.hpp"
+#include<algorithm>
 
 instruction_queue_rob::instruction_queue_rob(sc_module_name name, vector<string> inst_q,int rb_sz, nana::listbox &instr):
 sc_module(name),
@@ -7,6 +8,8 @@ instruct_queue(inst_q.size()),
 original_instruct(inst_q),
 last_instr(rb_sz),
 last_pc(rb_sz),
+last_saved(rb_sz),
+last_loops(rb_sz),
 instructions(instr)
 {
     for(unsigned int i = 0 ; i < inst_q.size() ; i++)
@@ -15,9 +18,24 @@ instructions(instr)
         instruct_queue[i].pc = i;
     }
 
+    fusion = 0;
+    fused_count = in_flight = 0;
+    select = NULL;
+    thread_id = 0;
+    pc = 0;
+    ftq_size = ftq_width = bpu_pc = 0;
+    ftq_blocks = ftq_stalls = ftq_resteers = ftq_cycles = ftq_hidden = 0;
+    bpu_last = -1;
+    ftq_area = 0;
+    last_opc = -1;
+    decode_wait = 0;
+    saved_until = SC_ZERO_TIME;
     SC_THREAD(main);
     sensitive << in;
     dont_initialize();
+    SC_THREAD(predict_blocks);
+    sensitive << in;
+    dont_initialize();
     SC_METHOD(leitura_rob);
     sensitive << in_rob;
     dont_initialize();
@@ -27,31 +45,299 @@ void instruction_queue_rob::main()
 {
     auto cat = instructions.at(0);
     pc = 0;
+    redirected = false;
     while(1)
     {
+        //LOOP: resolvida na busca, sem ocupar o ciclo de envio
+        if(pc < instruct_queue.size() && loop_unit::is_loop(instruct_queue[pc].instruction))
+        {
+            if(fetch_loop() == loop_unit::LOOP_WAIT)
+                wait();
+            continue;
+        }
+        //Front end desacoplado: espera o bloco da FTQ com esta instrucao
+        if(pc < instruct_queue.size() && ftq_size && !ftq_fetch(instruct_queue[pc].pc))
+        {
+            wait();
+            continue;
+        }
+        //Bolha da decodificacao quando a busca recomeca em outro endereco; com
+        //a FTQ ela e paga no bloco, a partir da predicao
+        if(pc < instruct_queue.size() && ucache.enabled() && !ftq_size && decode_stall(instruct_queue[pc].pc))
+        {
+            wait();
+            continue;
+        }
         if(pc < instruct_queue.size())
         {
+            if(select)
+                select->request(thread_id);
             if(pc)
-                cat.at(pc-1).select(false);
-            cat.at(pc).select(true,true);
-            cat.at(pc).text(ISS,"");
-            cat.at(pc).text(EXEC,"");
-            cat.at(pc).text(WRITE,"");
+                gui_row(pc-1).select(false);
+            gui_row(pc).select(true,true);
+            gui_row(pc).text(ISS,"");
+            gui_row(pc).text(EXEC,"");
+            gui_row(pc).text(WRITE,"");
             wait(SC_ZERO_TIME);
             wait(SC_ZERO_TIME);
             wait(SC_ZERO_TIME);
+            //Um flush durante a espera pode ter encurtado a fila
+            if(pc >= instruct_queue.size())
+                continue;
+            //SMT: outra thread pode ter ficado com a busca deste ciclo
+            if(select && !select->grant(thread_id))
+            {
+                wait();
+                continue;
+            }
             // Instructions + current_pc + pc_original_instruction
-            out->write(instruct_queue[pc].instruction + " " +
-                       std::to_string(pc)+ " " + 
-                       std::to_string(instruct_queue[pc].pc));
-            pc++;
-            wait(SC_ZERO_TIME);
-            cat.at(pc-1).text(ISS,std::to_string(sc_time_stamp().value() / 1000)); //cat.at(pc-1).text(ISS,"X");
+            string msg = instruct_queue[pc].instruction + " " +
+                         std::to_string(gpc(pc))+ " " + 
+                         std::to_string(instruct_queue[pc].pc);
+            //Par fundido: o desvio segue no mesmo envio, separado por ';'
+            unsigned int n = 1;
+            if(fusable(pc))
+            {
+                msg += ";" + instruct_queue[pc+1].instruction + " " +
+                       std::to_string(gpc(pc+1)) + " " +
+                       std::to_string(instruct_queue[pc+1].pc);
+                gui_row(pc+1).text(ISS,"");
+                gui_row(pc+1).text(EXEC,"");
+                gui_row(pc+1).text(WRITE,"");
+                n = 2;
+            }
+            redirected = false;
+            in_flight = n;
+            //Direcao que o ROB usa para os desvios vindos da FTQ
+            for(unsigned int k = 0 ; k < n && ftq_size ; k++)
+            {
+                int taken = ftq_taken(k);
+                if(taken >= 0)
+                    early_pred[gpc(pc+k)] = taken;
+            }
+            //O ROB pode reescrever a fila durante o envio
+            unsigned int sent_pc[2] = {instruct_queue[pc].pc, instruct_queue[pc+n-1].pc};
+            sc_time sent_at = sc_time_stamp();
+            out->write(msg);
+            in_flight = 0;
+            if(ftq_size)
+                ftq_consume(n);
+            if(ucache.enabled())
+            {
+                //So e ganho o envio aceito no mesmo ciclo: com o issue parado
+                //a busca esperaria de qualquer forma
+                if(sent_at < saved_until && sc_time_stamp() == sent_at)
+                    ucache.count_saved();
+                for(unsigned int k = 0 ; k < n ; k++)
+                    ucache.deliver(sent_pc[k]);
+                last_opc = sent_pc[1];
+            }
+            for(unsigned int k = 0 ; k < n ; k++)
+                loops.fetch(sent_pc[k]);
+            if(select)
+                select->release(thread_id);
+            //Se o ROB reverteu a fila durante o envio, pc ja aponta para o novo caminho
+            if(!redirected)
+            {
+                pc += n;
+                if(n == 2)
+                    fused_count++;
+                update_done();
+                wait(SC_ZERO_TIME);
+                for(unsigned int i = pc-n ; i < pc && gpc(i) < cat.size() ; i++)
+                    gui_row(i).text(ISS,std::to_string(sc_time_stamp().value() / 1000)); //cat.at(pc-1).text(ISS,"X");
+            }
+        }
+        wait();
+    }
+}
+
+//Preditor de desvios a frente da busca: um bloco previsto por ciclo na FTQ
+void instruction_queue_rob::predict_blocks()
+{
+    if(!ftq_size)
+        return;
+    while(true)
+    {
+        if(pc < instruct_queue.size())
+        {
+            ftq_cycles++;
+            ftq_area += ftq.size();
         }
+        if(ftq.size() < ftq_size && bpu_pc < original_instruct.size())
+            ftq_push(sc_time_stamp() + sc_time(1,SC_NS));
         wait();
     }
 }
 
+//Preve o bloco que comeca em bpu_pc, usavel pela busca a partir de ready
+void instruction_queue_rob::ftq_push(sc_time ready)
+{
+    ftq_block b = {bpu_pc,0,0,false,0,0,0,ready};
+    //Bloco fora da sequencia: a decodificacao do alvo comeca ja na
+    //predicao, enquanto a busca ainda envia os blocos anteriores
+    if(ucache.enabled() && bpu_last >= 0 && bpu_pc != (unsigned int)bpu_last + 1
+       && !loop_unit::is_loop(original_instruct[bpu_last]))
+    {
+        b.bubble = ucache.redirect(bpu_last,bpu_pc);
+        b.avoided = b.bubble ? 0 : ucache.get_latency();
+        b.ready = b.ready + sc_time(b.bubble,SC_NS);
+    }
+    unsigned int next = bpu_pc;
+    while(b.len < ftq_width && next < original_instruct.size())
+    {
+        unsigned int cur = next++;
+        unsigned int target;
+        b.len++;
+        //O bloco termina no desvio previsto como tomado
+        if(taken_target(cur,target))
+        {
+            next = target;
+            b.taken = true;
+            break;
+        }
+    }
+    bpu_last = b.start + b.len - 1;
+    bpu_pc = next;
+    ftq.push_back(b);
+    ftq_blocks++;
+}
+
+//Instrucao no PC original opc e um salto ou desvio previsto como tomado?
+bool instruction_queue_rob::taken_target(unsigned int opc, unsigned int &target)
+{
+    vector<string> ord = instruction_split(original_instruct[opc]);
+    //LOOP: o preditor supoe o laco continuando
+    if(ord[0] == "LOOP")
+    {
+        target = opc + std::stoi(ord[2]);
+        return true;
+    }
+    if(ord[0] != "J" && (ord[0].empty() || ord[0].at(0) != 'B'))
+        return false;
+    if(ord[0] != "J" && !ftq_predict(opc))
+        return false;
+    //Deslocamento: terceiro operando em BEQ/BNE, segundo nos outros desvios
+    unsigned int k = ord[0] == "J" ? 1 : (ord[0] == "BEQ" || ord[0] == "BNE") ? 3 : 2;
+    if(k >= ord.size())
+        return false;
+    target = opc + std::stoi(ord[k]);
+    return true;
+}
+
+//A busca da instrucao no PC original opc pode ocorrer neste ciclo?
+bool instruction_queue_rob::ftq_fetch(unsigned int opc)
+{
+    unsigned int expected = ftq.empty() ? bpu_pc : ftq.front().start + ftq.front().used;
+    if(expected != opc)
+    {
+        //A fila mudou de caminho (desvio revertido no commit, LOOP que saiu
+        //do laco ou replay de load): descarta os blocos e o preditor recomeca
+        //em opc, ja neste ciclo, com o endereco dado pelo redirecionamento
+        ftq.clear();
+        bpu_pc = opc;
+        bpu_last = last_opc;
+        ftq_resteers++;
+        ftq_push(sc_time_stamp());
+    }
+    if(ftq.empty() || ftq.front().ready > sc_time_stamp())
+    {
+        if(!ftq.empty())
+            ftq.front().waited++;
+        ftq_stalls++;
+        return false;
+    }
+    //Parte da bolha da decodificacao que passou antes da busca chegar ao bloco
+    ftq_block &b = ftq.front();
+    if(!b.used && b.bubble)
+    {
+        ftq_hidden += b.bubble - std::min(b.bubble,b.waited);
+        b.bubble = 0;
+    }
+    //Sem a cache de micro-ops ou o LSD o bloco so ficaria pronto avoided
+    //ciclos depois
+    if(!b.used && b.avoided)
+    {
+        saved_until = b.ready + sc_time(b.avoided,SC_NS);
+        b.avoided = 0;
+    }
+    return true;
+}
+
+//Direcao prevista para a k-esima instrucao a partir da cabeca da FTQ: so o
+//desvio no fim de um bloco terminado por salto foi previsto como tomado
+//(-1 se a instrucao ainda nao foi prevista)
+int instruction_queue_rob::ftq_taken(unsigned int k)
+{
+    for(unsigned int b = 0 ; b < ftq.size() ; b++)
+    {
+        unsigned int left = ftq[b].len - ftq[b].used;
+        if(k < left)
+            return ftq[b].taken && ftq[b].used + k == ftq[b].len - 1;
+        k -= left;
+    }
+    return -1;
+}
+
+void instruction_queue_rob::ftq_consume(unsigned int n)
+{
+    for(unsigned int k = 0 ; k < n && !ftq.empty() ; k++)
+        if(++ftq.front().used == ftq.front().len)
+            ftq.pop_front();
+}
+
+//Executa o LOOP em pc: no salto o caminho do alvo entra na fila depois dele
+int instruction_queue_rob::fetch_loop()
+{
+    unsigned int opc = instruct_queue[pc].pc;
+    unsigned int target;
+    int res = loops.step(opc,instruct_queue[pc].instruction,target);
+    if(res == loop_unit::LOOP_WAIT)
+        return res;
+    if(pc)
+        gui_row(pc-1).select(false);
+    gui_row(pc).select(true,true);
+    gui_row(pc).text(ISS,std::to_string(sc_time_stamp().value() / 1000));
+    gui_row(pc).text(EXEC,"");
+    gui_row(pc).text(WRITE,"");
+    pc++;
+    if(ftq_size && !ftq.empty() && ftq.front().start + ftq.front().used == opc)
+        ftq_consume(1);
+    if(res == loop_unit::LOOP_TAKEN)
+    {
+        vector<instr_q> new_instructions_vec;
+        for(unsigned int i = target ; i < original_instruct.size() ; i++)
+            new_instructions_vec.push_back({original_instruct[i],i});
+        add_instructions(pc,new_instructions_vec);
+        //O alvo ja esta no buffer do laco: a busca segue sem reinicio
+        if(last_opc >= 0)
+            last_opc = (int)target - 1;
+    }
+    else if(last_opc >= 0)
+        last_opc = opc;
+    update_done();
+    return res;
+}
+
+//A busca em opc espera a decodificacao neste ciclo?
+bool instruction_queue_rob::decode_stall(unsigned int opc)
+{
+    if(last_opc >= 0 && opc != (unsigned int)last_opc + 1)
+    {
+        decode_wait = ucache.redirect(last_opc,opc);
+        //Reinicio sem bolha: os envios ate o fim da bolha evitada sao ganho
+        if(!decode_wait)
+            saved_until = sc_time_stamp() + sc_time(ucache.get_latency(),SC_NS);
+        last_opc = (int)opc - 1;
+    }
+    if(decode_wait)
+    {
+        decode_wait--;
+        return true;
+    }
+    return false;
+}
+
 void instruction_queue_rob::leitura_rob()
 {
     string p;
@@ -61,9 +347,13 @@ void instruction_queue_rob::leitura_rob()
     in_rob->read(p);
     ord = instruction_split(p);
     index = std::stoi(ord[1])-1; //ROB position
+    //SMT: mensagem para a fila de outra thread
+    if(select && select->entry_thread(index+1) != thread_id)
+        return;
     if(ord[0] == "R") //reverter salto incorreto
     {
-        instructions.at(0).at(pc-1).select(false);
+        redirected = true;
+        gui_row(pc-1).select(false);
         //replace_instructions(last_pc[index]-1,index);
         //pc = last_pc[index]-1;
         
@@ -72,21 +362,37 @@ void instruction_queue_rob::leitura_rob()
         pc = last_pc[index];
         
         instruct_queue = last_instr[index]; 
+        loops.set_state(last_loops[index]);
+        ucache.discard_saved(last_saved[index]);
     }
     else if(ord[0] == "S" && ord.size() == 3) //realiza salto (especulado) e armazena informacoes pre-salto
     {
+        //A predicao pode chegar antes do fim do envio (par fundido): o desvio
+        //e a ultima instrucao em envio
+        unsigned int at = pc + in_flight;
         last_instr[index] = instruct_queue;
-        last_pc[index] = pc;
+        last_pc[index] = at;
+        last_loops[index] = loops.get_state();
+        last_saved[index] = ucache.get_saved();
         vector<instr_q> new_instructions_vec;
         offset = std::stoi(ord[2]);
-        unsigned int original_pc = instruct_queue[pc-1].pc;
+        unsigned int original_pc = instruct_queue[at-1].pc;
         for(unsigned int i = original_pc+offset ; i < original_instruct.size() ; i++)
             new_instructions_vec.push_back({original_instruct[i],i});
-        add_instructions(pc,new_instructions_vec);
+        add_instructions(at,new_instructions_vec);
     }
     else if(ord[0] == "S") //Não há salto, continua na instrução de baixo (especulado)
     {
-        last_pc[index] = pc;
+        last_pc[index] = pc + in_flight;
+        last_loops[index] = loops.get_state();
+        last_saved[index] = ucache.get_saved();
+    }
+    else if(ord[0] == "V") //load com valor previsto: um R volta para a instrucao seguinte ao load
+    {
+        last_instr[index] = instruct_queue;
+        last_pc[index] = (std::stoi(ord[2]) - gpc(0))/(select ? select->get_threads() : 1) + 1;
+        last_loops[index] = loops.get_state();
+        last_saved[index] = ucache.get_saved();
     }
     // else if para tratar JUMP, onde o salto ocorre e não é especulado.
     else if(ord[0] == "J"){
@@ -99,15 +405,19 @@ void instruction_queue_rob::leitura_rob()
     }
     else //salta atrasado (quando foi predito que nao saltaria)
     {
+        redirected = true;
         vector<instr_q> new_instructions_vec;
         offset = std::stoi(ord[0]);
-        instructions.at(0).at(pc-1).select(false);
+        gui_row(pc-1).select(false);
         pc = last_pc[index];
+        loops.set_state(last_loops[index]);
+        ucache.discard_saved(last_saved[index]);
         unsigned int original_pc = instruct_queue[pc-1].pc;
         for(unsigned int i = original_pc+offset ; i < original_instruct.size() ; i++)
             new_instructions_vec.push_back({original_instruct[i],i});
         add_instructions(pc,new_instructions_vec);
     }
+    update_done();
 }
 
 void instruction_queue_rob::replace_instructions(unsigned int pos,unsigned int index)
@@ -115,6 +425,19 @@ void instruction_queue_rob::replace_instructions(unsigned int pos,unsigned int i
     auto cat = instructions.at(0);
     unsigned int sz = instruct_queue.size();
     unsigned int i;
+    //SMT: as linhas das threads se intercalam e nao podem ser removidas
+    if(select)
+    {
+        unsigned int end = last_instr[index].size();
+        instruct_queue.resize(end);
+        for(i = pos ; i < std::max(sz,end) ; i++)
+        {
+            if(i < end)
+                instruct_queue[i] = last_instr[index][i];
+            show_instruction(i);
+        }
+        return;
+    }
     instructions.auto_draw(false);
     for(i = pos ; i < last_instr[index].size() ; i++)
     {
@@ -150,6 +473,18 @@ void instruction_queue_rob::add_instructions(unsigned int pos, vector<instr_q> i
     unsigned int sz = instruct_queue.size();
     auto cat = instructions.at(0);
     unsigned int i = pos;
+    if(select)
+    {
+        unsigned int end = pos + instr_vec.size();
+        instruct_queue.resize(end);
+        for(; i < std::max(sz,end) ; i++)
+        {
+            if(i < end)
+                instruct_queue[i] = instr_vec[i-pos];
+            show_instruction(i);
+        }
+        return;
+    }
     instructions.auto_draw(false);
     for(; i < pos + instr_vec.size() ; i++)
     {
@@ -179,11 +514,146 @@ void instruction_queue_rob::add_instructions(unsigned int pos, vector<instr_q> i
     instructions.auto_draw(true);
 }
 
+void instruction_queue_rob::set_fusion(int mask)
+{
+    fusion = mask;
+}
+
+unsigned int instruction_queue_rob::get_fused_count()
+{
+    return fused_count;
+}
+
+//A instrucao i e o desvio seguinte podem ocupar uma unica entrada do ROB?
+bool instruction_queue_rob::fusable(unsigned int i)
+{
+    if(!fusion || i+1 >= instruct_queue.size())
+        return false;
+    vector<string> first = instruction_split(instruct_queue[i].instruction);
+    vector<string> br = instruction_split(instruct_queue[i+1].instruction);
+    bool cmp = first[0] == "SLT" || first[0] == "SGT";
+    bool alu = first[0] == "DADD" || first[0] == "DADDI" || first[0] == "DADDU" ||
+               first[0] == "DADDIU" || first[0] == "DSUB" || first[0] == "DSUBU";
+    if(!((cmp && (fusion & FUSE_CMP_BRANCH)) || (alu && (fusion & FUSE_ALU_BRANCH))))
+        return false;
+    if(br[0].at(0) != 'B' || first.size() < 4 || first[1].at(0) != 'R' || first[1] == "R0")
+        return false;
+    //O desvio deve ler o resultado em exatamente um dos operandos
+    if(br[0] == "BEQ" || br[0] == "BNE")
+        return br.size() >= 4 && ((br[1] == first[1]) != (br[2] == first[1]));
+    return br.size() >= 3 && br[1] == first[1];
+}
+
 bool instruction_queue_rob::queue_is_empty(){
     
+    //SMT: a simulacao termina quando as filas de todas as threads chegam ao fim
+    if(select)
+        return select->all_done();
     return pc == instruct_queue.size();
 }
 
 unsigned int instruction_queue_rob::get_instruction_counter() {
     return pc;
 }
+
+void instruction_queue_rob::set_ftq(unsigned int size, unsigned int block, std::function<bool(unsigned int)> predict)
+{
+    ftq_size = size;
+    ftq_width = block;
+    ftq_predict = predict;
+}
+
+unsigned int instruction_queue_rob::get_ftq_size()
+{
+    return ftq_size;
+}
+
+unsigned int instruction_queue_rob::get_ftq_blocks()
+{
+    return ftq_blocks;
+}
+
+unsigned int instruction_queue_rob::get_ftq_stalls()
+{
+    return ftq_stalls;
+}
+
+unsigned int instruction_queue_rob::get_ftq_resteers()
+{
+    return ftq_resteers;
+}
+
+unsigned int instruction_queue_rob::get_ftq_hidden()
+{
+    return ftq_hidden;
+}
+
+int instruction_queue_rob::fetch_prediction(unsigned int gpc)
+{
+    auto it = early_pred.find(gpc);
+    return it == early_pred.end() ? -1 : it->second;
+}
+
+double instruction_queue_rob::get_ftq_occupancy()
+{
+    return ftq_cycles ? ftq_area/ftq_cycles : 0;
+}
+
+void instruction_queue_rob::set_uop_cache(unsigned int entries, unsigned int lsd_size, unsigned int latency)
+{
+    ucache = uop_cache(entries,lsd_size,latency);
+}
+
+uop_cache &instruction_queue_rob::get_uop_cache()
+{
+    return ucache;
+}
+
+void instruction_queue_rob::set_regs(nana::listbox *regs)
+{
+    loops.set_regs(regs);
+}
+
+loop_unit &instruction_queue_rob::get_loop_unit()
+{
+    return loops;
+}
+
+void instruction_queue_rob::set_smt(thread_select *s, unsigned int id)
+{
+    select = s;
+    thread_id = id;
+    select->set_done(thread_id,instruct_queue.empty());
+}
+
+//Linha da instrucao i na fila da interface: no SMT as threads se intercalam
+unsigned int instruction_queue_rob::gpc(unsigned int i)
+{
+    if(!select)
+        return i;
+    return i*select->get_threads() + thread_id;
+}
+
+nana::listbox::item_proxy instruction_queue_rob::gui_row(unsigned int i)
+{
+    auto cat = instructions.at(0);
+    while(cat.size() <= gpc(i))
+        cat.append("");
+    return cat.at(gpc(i));
+}
+
+//Mostra a instrucao i (ou uma linha vazia alem do fim da fila) sem tempos
+void instruction_queue_rob::show_instruction(unsigned int i)
+{
+    auto row = gui_row(i);
+    row.text(INSTR,i < instruct_queue.size() ? instruct_queue[i].instruction : "");
+    row.text(ISS,"");
+    row.text(EXEC,"");
+    row.text(WRITE,"");
+}
+
+void instruction_queue_rob::update_done()
+{
+    if(select)
+        select->set_done(thread_id,pc >= instruct_queue.size());
+}
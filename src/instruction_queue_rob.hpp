@@ -1,9 +1,15 @@
 #include<systemc.h>
 #include<vector>
+#include<deque>
+#include<functional>
 #include "interfaces.hpp"
+#include "thread_select.hpp"
+#include "uop_cache.hpp"
+#include "loop_unit.hpp"
 #include<nana/gui/widgets/listbox.hpp>
 
 using std::vector;
+using std::deque;
 
 class instruction_queue_rob: public sc_module
 {
@@ -16,12 +22,73 @@ public:
     instruction_queue_rob(sc_module_name name, vector<string> inst_q,int rb_sz, nana::listbox &instr);
     void main();
     void leitura_rob();
+    void predict_blocks();
 
     bool queue_is_empty();
     unsigned int get_instruction_counter();
+    // Fusao de macro-ops no decode: FUSE_CMP_BRANCH une SLT/SGT ao desvio
+    // seguinte que le o resultado; FUSE_ALU_BRANCH faz o mesmo com somas e
+    // subtracoes inteiras (DADD, DADDI, DSUB...)
+    enum { FUSE_CMP_BRANCH = 1, FUSE_ALU_BRANCH = 2 };
+    void set_fusion(int mask);
+    unsigned int get_fused_count();
+    // SMT: fila da thread id, com a busca dividida pelo arbitro s
+    void set_smt(thread_select *s, unsigned int id);
+    // Front end desacoplado: a cada ciclo o preditor de desvios, a frente da
+    // busca, poe na fila de alvos de busca (FTQ, size blocos) um bloco de ate
+    // block instrucoes que termina no primeiro desvio previsto como tomado;
+    // a busca segue os blocos da FTQ e o ROB usa a direcao prevista neles.
+    // Um bloco que comeca fora da sequencia ja inicia a decodificacao na
+    // predicao, escondendo a bolha atras da busca dos blocos anteriores.
+    // predict da a direcao prevista do desvio no PC original
+    void set_ftq(unsigned int size, unsigned int block, std::function<bool(unsigned int)> predict);
+    unsigned int get_ftq_size();
+    unsigned int get_ftq_blocks();
+    unsigned int get_ftq_stalls();
+    unsigned int get_ftq_resteers();
+    unsigned int get_ftq_hidden();
+    // Direcao prevista pela FTQ para o desvio enviado na posicao gpc da fila
+    // (-1 se ele nao veio de um bloco da FTQ)
+    int fetch_prediction(unsigned int gpc);
+    double get_ftq_occupancy();
+    // Latencia da decodificacao a cada reinicio da busca, cache de micro-ops
+    // com entries instrucoes e detector de lacos de ate lsd_size instrucoes
+    void set_uop_cache(unsigned int entries, unsigned int lsd_size, unsigned int latency);
+    uop_cache &get_uop_cache();
+    // Banco de registradores lido pelas instrucoes LOOP
+    void set_regs(nana::listbox *regs);
+    loop_unit &get_loop_unit();
     
 private:
     unsigned int pc;
+    bool redirected; //ROB reverteu a fila durante o envio de uma instrucao
+    int fusion;
+    unsigned int fused_count; //pares enviados como uma unica instrucao
+    unsigned int in_flight; //instrucoes em envio, ainda nao contadas em pc
+    thread_select *select;
+    unsigned int thread_id;
+
+    struct ftq_block
+    {
+        unsigned int start,len,used; //PCs originais start..start+len-1, used ja buscados
+        bool taken; //termina em um desvio previsto como tomado
+        unsigned int bubble,waited; //bolha da decodificacao e ciclos que a busca esperou
+        unsigned int avoided; //bolha evitada pela cache de micro-ops ou pelo LSD
+        sc_time ready; //ciclo em que a busca pode usar o bloco
+    };
+    deque<ftq_block> ftq;
+    unsigned int ftq_size,ftq_width;
+    unsigned int bpu_pc; //PC original do proximo bloco a prever
+    int bpu_last; //PC original da ultima instrucao prevista (-1 = nenhuma)
+    map<unsigned int,bool> early_pred; //direcao da FTQ por posicao na fila
+    std::function<bool(unsigned int)> ftq_predict;
+    unsigned int ftq_blocks,ftq_stalls,ftq_resteers,ftq_cycles,ftq_hidden;
+    double ftq_area; //soma da ocupacao da FTQ por ciclo
+    uop_cache ucache;
+    int last_opc; //PC original da ultima instrucao enviada (-1 = nenhuma)
+    unsigned int decode_wait; //ciclos de bolha restantes da decodificacao
+    sc_time saved_until; //fim da bolha evitada no ultimo reinicio da busca
+    loop_unit loops;
     
     struct instr_q
     {
@@ -33,8 +100,22 @@ private:
     vector<string> original_instruct;
     vector<vector<instr_q>> last_instr;
     vector<unsigned int> last_pc;
+    vector<unsigned int> last_saved; //busca poupada ate o desvio especulado
+    vector<map<unsigned int,loop_unit::hw_loop>> last_loops; //contadores no desvio especulado
     nana::listbox &instructions;
 
     void replace_instructions(unsigned int pos,unsigned int index);
     void add_instructions(unsigned int pos, vector<instr_q> instructions);
+    bool fusable(unsigned int i);
+    unsigned int gpc(unsigned int i);
+    nana::listbox::item_proxy gui_row(unsigned int i);
+    void show_instruction(unsigned int i);
+    void update_done();
+    bool taken_target(unsigned int opc, unsigned int &target);
+    bool ftq_fetch(unsigned int opc);
+    void ftq_consume(unsigned int n);
+    int ftq_taken(unsigned int k);
+    void ftq_push(sc_time ready);
+    bool decode_stall(unsigned int opc);
+    int fetch_loop();
 };
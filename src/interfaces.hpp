@@ -25,6 +25,14 @@ class write_if: virtual public sc_interface
         virtual void write(string) = 0;
 };
 
+// Escrita com prioridade: entre escritas no mesmo ciclo vence a de maior prioridade
+class prio_write_if: virtual public write_if
+{
+    public:
+        using write_if::write;
+        virtual void write(string, unsigned int) = 0;
+};
+
 class read_if: virtual public sc_interface
 {
     public:
@@ -9,14 +9,24 @@ issue_control_rob::issue_control_rob(sc_module_name name): sc_module(name)
                 {"DADDIU",1},{"DSUB",1},{"DSUBU",1},
                 {"DMUL",1},{"DMULU",1},{"DDIV",1},
                 {"DDIVU",1},{"SLT", 1},{"SGT", 1},
-                {"LD",2},{"SD",3},
+                {"DFMA",1},{"MOVZ",1},{"MOVN",1},{"ADDV",1},{"SUBV",1},
+                {"MULV",1},{"SEQV",1},{"SUMV",1},
+                {"LV",2},{"SV",3},
+                {"LD",2},{"SD",3},{"PREF",2},{"SDNT",3},
+                {"LLD",2},{"SCD",3},{"SYNC",4},
                 {"BEQ",4},{"BNE",4},{"BGTZ",4},
                 {"BLTZ",4},{"BGEZ",4},{"BLEZ",4},
                 {"J", 4}};
 
+    isFlushed = false;
+    smt = NULL;
+    issue_thread = 0;
     SC_THREAD(issue_select);
     sensitive << in;
     dont_initialize();
+    SC_METHOD(leitura_iq);
+    sensitive << in_iq;
+    dont_initialize();
 }
 
 void issue_control_rob::issue_select()
@@ -25,21 +35,41 @@ void issue_control_rob::issue_select()
     while(true)
     {
         in->nb_read(p);
+        isFlushed = false;
+        //Macro-op: o ROB recebe o par inteiro, as estacoes apenas a primeira instrucao
+        string inst = p.substr(0,p.find(';'));
+        ord = instruction_split(inst);
+        if(smt)
+            issue_thread = smt->instr_thread(std::stoi(ord[ord.size()-2]));
         out_rob->write(p);
         in_rob->read(rob_pos);
-        ord = instruction_split(p);
+        //Instrucao do caminho descartado por um flush do ROB
+        if(isFlushed || rob_pos == "0")
+        {
+            in->notify();
+            wait();
+            continue;
+        }
+        //Eliminada no rename: o ROB ja tem o resultado, nao ocupa estacao
+        if(rob_pos.at(0) == 'E')
+        {
+            in->notify();
+            wait();
+            continue;
+        }
         switch(res_type[ord[0]])
         {
             case 1:
-                out_rsv->write(p + ' ' + rob_pos);
+                out_rsv->write(inst + ' ' + rob_pos);
                 break;
             case 2:
-                out_slbuff->write(p + ' ' + rob_pos);
+                out_slbuff->write(inst + ' ' + rob_pos);
                 in_slbuff->read(slb_p);
-                out_adu->write(p + ' ' + rob_pos + ' ' +  slb_p);
+                if(!isFlushed && slb_p != "-1")
+                    out_adu->write(inst + ' ' + rob_pos + ' ' +  slb_p);
                 break;
             case 3:
-                out_adu->write(p + ' ' + rob_pos);
+                out_adu->write(inst + ' ' + rob_pos);
                 break;
             case 4:
                 break;
@@ -53,3 +83,20 @@ void issue_control_rob::issue_select()
     }
 }
 
+void issue_control_rob::leitura_iq()
+{
+    string msg;
+    vector<string> ord_iq;
+    in_iq->read(msg);
+    ord_iq = instruction_split(msg);
+    //Mensagens S, J e V apenas informam o salto especulado ou o ponto de retorno
+    //de um load previsto; as demais revertem a fila
+    if(ord_iq[0] != "S" && ord_iq[0] != "J" && ord_iq[0] != "V")
+        if(!smt || smt->entry_thread(std::stoi(ord_iq[1])) == issue_thread)
+            isFlushed = true;
+}
+
+void issue_control_rob::set_smt(thread_select *s)
+{
+    smt = s;
+}
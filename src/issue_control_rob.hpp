@@ -1,4 +1,5 @@
 #include "interfaces.hpp"
+#include "thread_select.hpp"
 #include<map>
 #include<vector>
 
@@ -15,12 +16,19 @@ public:
     sc_port<read_if_f> in_rob;
     sc_port<write_if_f> out_rob;
     sc_port<write_if_f> out_adu;
+    sc_port<read_if> in_iq; //mensagens do ROB para a fila de instrucoes
     SC_HAS_PROCESS(issue_control_rob);
     
     issue_control_rob(sc_module_name name);
     void issue_select();
+    void leitura_iq();
+    // SMT: um redirecionamento so descarta a instrucao em issue se for da mesma thread
+    void set_smt(thread_select *s);
 
 private:
+    bool isFlushed; //flush ocorreu durante o issue da instrucao atual
+    thread_select *smt;
+    unsigned int issue_thread; //thread da instrucao em issue
     string p,rob_pos;
     vector<string> ord;
     map<string,unsigned short int> res_type;
@@ -0,0 +1,81 @@
+#include "loop_unit.hpp"
+#include "general.hpp"
+
+loop_unit::loop_unit()
+{
+    regs = NULL;
+    taken = exits = waits = 0;
+}
+
+void loop_unit::set_regs(nana::listbox *r)
+{
+    regs = r;
+}
+
+bool loop_unit::is_loop(const string &inst)
+{
+    return inst.compare(0,5,"LOOP ") == 0;
+}
+
+int loop_unit::step(unsigned int opc, const string &inst, unsigned int &target)
+{
+    vector<string> ord = instruction_split(inst);
+    target = opc + std::stoi(ord[2]);
+    if(!loops.count(opc))
+    {
+        //Coluna 1: valor; coluna 2: entrada do ROB (ou estacao) que vai escrever
+        auto row = regs->at(0).at(std::stoi(ord[1].substr(1)));
+        string q = row.text(2);
+        if(q != "" && q != "0")
+        {
+            waits++;
+            return LOOP_WAIT;
+        }
+        string v = row.text(1);
+        loops[opc] = {v != "" ? std::stoi(v) : 0,target};
+    }
+    if(--loops[opc].count > 0)
+    {
+        taken++;
+        return LOOP_TAKEN;
+    }
+    loops.erase(opc);
+    exits++;
+    return LOOP_EXIT;
+}
+
+void loop_unit::fetch(unsigned int opc)
+{
+    for(auto it = loops.begin() ; it != loops.end() ; )
+    {
+        if(opc < it->second.start || opc > it->first)
+            it = loops.erase(it);
+        else
+            it++;
+    }
+}
+
+map<unsigned int,loop_unit::hw_loop> loop_unit::get_state()
+{
+    return loops;
+}
+
+void loop_unit::set_state(const map<unsigned int,hw_loop> &state)
+{
+    loops = state;
+}
+
+unsigned int loop_unit::get_taken()
+{
+    return taken;
+}
+
+unsigned int loop_unit::get_exits()
+{
+    return exits;
+}
+
+unsigned int loop_unit::get_waits()
+{
+    return waits;
+}
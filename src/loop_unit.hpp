@@ -0,0 +1,44 @@
+#pragma once
+#include<map>
+#include<string>
+#include<nana/gui/widgets/listbox.hpp>
+
+using std::map;
+using std::string;
+
+// Laco em hardware: LOOP Rn,desloc e resolvida na busca, sem entrada no ROB,
+// preditor ou CDB. Na primeira chegada ao LOOP o contador do laco recebe o
+// valor de Rn, lido do banco de registradores quando nao ha escrita pendente
+// (a busca espera ate la). A cada chegada o contador e decrementado e,
+// enquanto for positivo, a busca segue para o alvo: o corpo executa Rn vezes
+// (ao menos uma). Rn nao e alterado. Sair do corpo por um desvio descarta o
+// contador.
+class loop_unit
+{
+public:
+    enum { LOOP_WAIT, LOOP_TAKEN, LOOP_EXIT };
+    struct hw_loop
+    {
+        int count; //iteracoes restantes
+        unsigned int start; //PC original do alvo, inicio do corpo
+    };
+
+    loop_unit();
+    void set_regs(nana::listbox *regs);
+    static bool is_loop(const string &inst);
+    // LOOP no PC original opc; em LOOP_TAKEN target e o PC original do alvo
+    int step(unsigned int opc, const string &inst, unsigned int &target);
+    // Instrucao no PC original opc buscada: descarta os lacos que nao a contem
+    void fetch(unsigned int opc);
+    // Contadores ativos, guardados a cada desvio especulado para a recuperacao
+    map<unsigned int,hw_loop> get_state();
+    void set_state(const map<unsigned int,hw_loop> &state);
+    unsigned int get_taken();
+    unsigned int get_exits();
+    unsigned int get_waits();
+
+private:
+    nana::listbox *regs;
+    map<unsigned int,hw_loop> loops; //LOOPs ativos, pelo PC original
+    unsigned int taken,exits,waits;
+};
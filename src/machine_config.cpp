@@ -0,0 +1,254 @@
+#include "machine_config.hpp"
+#include<fstream>
+#include<sstream>
+#include<climits>
+#include<algorithm>
+#include<cstdlib>
+
+// Novas chaves (e novas instrucoes com latencia) devem ser adicionadas aqui
+const map<string,pair<int,int>> machine_config::limits = {
+    {"MODE",{0,2}},{"PRED_BITS",{1,3}},{"BPB_SIZE",{2,10}},{"ROB_SIZE",{1,256}},
+    {"CPU_FREQ",{1,100000}},{"RS_ADD",{1,64}},{"RS_MUL",{1,64}},{"RS_LOAD",{1,64}},
+    {"LAT_DADD",{1,1000}},{"LAT_DADDI",{1,1000}},{"LAT_DSUB",{1,1000}},
+    {"LAT_DSUBI",{1,1000}},{"LAT_DMUL",{1,1000}},{"LAT_DDIV",{1,1000}},
+    {"LAT_MEM",{1,1000}},{"LAT_SLT",{1,1000}},{"LAT_SGT",{1,1000}},
+    {"LAT_DFMA",{1,1000}},
+    {"SELECT_POLICY",{0,4}},{"FU_ADD",{0,64}},{"FU_MUL",{0,64}},
+    {"FU_FMA",{0,64}},{"VLEN",{0,64}},{"VWIDTH",{0,64}},
+    {"FU_VEC",{0,64}},{"CRIT_SIZE",{0,4096}},{"CRIT_CDB",{0,1}},
+    {"RS_UNIFIED",{0,1}},{"RS_TOTAL",{0,192}},{"RS_LIMIT_ADD",{0,192}},
+    {"RS_LIMIT_MUL",{0,192}},{"RS_LIMIT_LOAD",{0,192}},
+    {"RF_READ_PORTS",{0,64}},{"RF_WRITE_PORTS",{0,64}},
+    {"BYPASS_LATENCY",{0,100}},{"BYPASS_PARTIAL",{0,1}},{"BYPASS_MISS",{0,100}},
+    {"CLUSTERS",{0,8}},{"CLUSTER_DELAY",{0,100}},{"CLUSTER_STEER",{0,1}},
+    {"FTQ_SIZE",{0,64}},{"FTQ_BLOCK",{0,32}},{"DECODE_LATENCY",{0,100}},
+    {"UOP_CACHE",{0,4096}},{"LSD_SIZE",{0,256}},{"FUSION",{0,3}},
+    {"MOVE_ELIM",{0,3}},{"VALUE_PRED",{0,2}},{"VP_SIZE",{0,4096}},{"VP_CONF",{0,3}},
+    {"DCACHE_LINES",{0,65536}},{"DCACHE_BLOCK",{0,64}},{"MISS_LATENCY",{0,1000}},
+    {"RUNAHEAD",{0,1000}},{"SMT_THREADS",{0,8}},{"SMT_POLICY",{0,1}},
+    {"SMT_MEM_STRIDE",{0,1 << 24}},{"CORES",{0,16}},{"CORE_MEM_STRIDE",{0,1 << 24}},
+    {"BUS_LATENCY",{0,1000}}
+};
+
+//Capacidade maxima da cache de dados, em palavras (DCACHE_LINES*DCACHE_BLOCK)
+static const long max_dcache_words = 1 << 16;
+
+machine_config::machine_config(string preset_dir):
+preset_dir(preset_dir)
+{
+}
+
+bool machine_config::load(string path)
+{
+    errors.clear();
+    loading.clear();
+    if(!read(path,"",""))
+        errors.push_back("nao foi possivel abrir " + path);
+    else
+        check();
+    return errors.empty();
+}
+
+bool machine_config::load_latencies(string path)
+{
+    errors.clear();
+    loading.clear();
+    if(!read(path,"","LAT_"))
+        errors.push_back("nao foi possivel abrir " + path);
+    return errors.empty();
+}
+
+bool machine_config::load_values(const map<string,int> &v, string where)
+{
+    errors.clear();
+    for(auto &k : v)
+        if(!limits.count(k.first))
+            errors.push_back(where + ": chave " + k.first + " desconhecida");
+        else
+            set(k.first,k.second,where);
+    check();
+    return errors.empty();
+}
+
+const vector<string> &machine_config::get_errors()
+{
+    return errors;
+}
+
+bool machine_config::has(string key)
+{
+    return values.count(key);
+}
+
+int machine_config::get(string key)
+{
+    return values.count(key) ? values[key] : 0;
+}
+
+map<string,int> machine_config::get_config()
+{
+    map<string,int> res;
+    for(auto &v : values)
+        if(!machine_key(v.first))
+            res[v.first] = v.second;
+    return res;
+}
+
+map<string,int> machine_config::get_latencies()
+{
+    map<string,int> res;
+    for(auto &v : values)
+        if(v.first.rfind("LAT_",0) == 0)
+            res[v.first.substr(4)] = v.second;
+    return res;
+}
+
+void machine_config::add_text_key(string key, bool path)
+{
+    text_keys[key] = path;
+}
+
+bool machine_config::has_text(string key)
+{
+    return texts.count(key);
+}
+
+string machine_config::get_text(string key)
+{
+    return texts.count(key) ? texts[key] : "";
+}
+
+bool machine_config::machine_key(string key)
+{
+    return key == "MODE" || key == "PRED_BITS" || key == "BPB_SIZE" || key == "CPU_FREQ"
+           || key == "RS_ADD" || key == "RS_MUL" || key == "RS_LOAD" || key.rfind("LAT_",0) == 0;
+}
+
+//Le um arquivo (a descricao ou um preset); where e o "arquivo:linha" do PRESET
+//e prefix e acrescentado a cada chave (LAT_ no arquivo do '-l')
+bool machine_config::read(string path, string where, string prefix)
+{
+    std::ifstream in(path);
+    if(!in.is_open())
+        return false;
+    //O mesmo arquivo pode ser alcancado por caminhos diferentes
+    char real[PATH_MAX];
+    string id = realpath(path.c_str(),real) ? string(real) : path;
+    for(unsigned int i = 0 ; i < loading.size() ; i++)
+        if(loading[i] == id)
+        {
+            errors.push_back(where + ": heranca circular com " + path);
+            return true;
+        }
+    loading.push_back(id);
+    size_t slash = path.find_last_of('/');
+    string dir = slash == string::npos ? "." : path.substr(0,slash);
+    string raw;
+    unsigned int n = 0;
+    while(getline(in,raw))
+    {
+        n++;
+        string here = path + ":" + std::to_string(n);
+        size_t cut = std::min(raw.find("//"),raw.find('#'));
+        std::istringstream line(raw.substr(0,cut == string::npos ? raw.size() : cut));
+        string key,value,extra;
+        if(!(line >> key))
+            continue;
+        if(!(line >> value) || line >> extra)
+        {
+            errors.push_back(here + ": esperado <CHAVE> <valor>");
+            continue;
+        }
+        key = prefix + key;
+        if(key == "PRESET")
+        {
+            if(!read(dir + "/" + value + ".txt",here,prefix) && !read(preset_dir + "/" + value + ".txt",here,prefix))
+                errors.push_back(here + ": preset " + value + " nao encontrado");
+            continue;
+        }
+        if(text_keys.count(key))
+        {
+            texts[key] = text_keys[key] && value[0] != '/' ? dir + "/" + value : value;
+            continue;
+        }
+        if(!limits.count(key))
+        {
+            errors.push_back(here + ": chave " + key + " desconhecida");
+            continue;
+        }
+        size_t used = 0;
+        long v = 0;
+        try
+        {
+            v = std::stol(value,&used);
+        }
+        catch(...)
+        {
+            used = 0;
+        }
+        if(used != value.size())
+            errors.push_back(here + ": valor " + value + " de " + key + " nao e inteiro");
+        else
+            set(key,v,here);
+    }
+    loading.pop_back();
+    return true;
+}
+
+//Guarda o valor de uma chave conhecida se estiver dentro dos limites
+void machine_config::set(string key, long v, string here)
+{
+    auto lim = limits.find(key);
+    if(v < lim->second.first || v > lim->second.second)
+        errors.push_back(here + ": " + key + " fora dos limites (" + std::to_string(lim->second.first) + " a "
+                         + std::to_string(lim->second.second) + ")");
+    else
+    {
+        values[key] = v;
+        origin[key] = here;
+    }
+}
+
+//Erro de uma chave que conflita com outra, com o arquivo e a linha de cada uma
+void machine_config::conflict(string key, string other, string reason)
+{
+    string msg = origin.count(key) ? origin[key] + ": " : "";
+    msg += key + " " + std::to_string(get(key));
+    if(origin.count(other))
+        msg += " (com " + other + " " + std::to_string(get(other)) + " em " + origin[other] + ")";
+    errors.push_back(msg + ": " + reason);
+}
+
+//Conferencias entre chaves, feitas com os valores finais (depois dos presets)
+void machine_config::check()
+{
+    //Cada cluster recebe ao menos uma unidade das classes com FU_* (FU_* 0 e
+    //a unidade unica compartilhada)
+    if(get("CLUSTERS") > 1)
+        for(string fu : {"FU_ADD","FU_MUL","FU_FMA","FU_VEC"})
+            if(get(fu) > 0 && get(fu) < get("CLUSTERS"))
+                conflict(fu,"CLUSTERS","menos unidades que clusters");
+    int vlen = get("VLEN") ? get("VLEN") : 4;
+    if(get("VWIDTH") > vlen)
+        conflict("VWIDTH","VLEN","largura maior que o vetor de " + std::to_string(vlen) + " elementos");
+    //RS_TOTAL 0 e a soma das estacoes de cada classe
+    int window = get("RS_TOTAL") ? get("RS_TOTAL")
+                 : (has("RS_ADD") ? get("RS_ADD") : 3) + (has("RS_MUL") ? get("RS_MUL") : 2) + (has("RS_LOAD") ? get("RS_LOAD") : 2);
+    for(string lim : {"RS_LIMIT_ADD","RS_LIMIT_MUL","RS_LIMIT_LOAD"})
+        if(get(lim) > window)
+            conflict(lim,"RS_TOTAL","limite maior que a janela de " + std::to_string(window) + " estacoes");
+    //Sem DCACHE_LINES (e fora do multicore) nao ha cache de dados
+    if(!get("DCACHE_LINES") && !get("CORES"))
+    {
+        for(string key : {"DCACHE_BLOCK","MISS_LATENCY"})
+            if(get(key))
+                conflict(key,"DCACHE_LINES","a cache de dados esta desligada (DCACHE_LINES 0)");
+    }
+    else
+    {
+        long words = (long)(get("DCACHE_LINES") ? get("DCACHE_LINES") : 16)*(get("DCACHE_BLOCK") ? get("DCACHE_BLOCK") : 4);
+        if(words > max_dcache_words)
+            conflict("DCACHE_LINES","DCACHE_BLOCK","cache de dados de " + std::to_string(words) + " palavras (maximo "
+                     + std::to_string(max_dcache_words) + ")");
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<map>
+#include<utility>
+
+using std::vector;
+using std::string;
+using std::map;
+using std::pair;
+
+// Descricao da maquina: um arquivo com todos os parametros, no formato
+// "<CHAVE> <valor>" do '-c' (uma chave por linha, comentarios com "//" ou "#").
+// Alem das chaves do modo com especulacao ha as da maquina:
+//   MODE         0 sem especulacao, 1 um preditor, 2 BPB
+//   PRED_BITS    bits do preditor; BPB_SIZE tamanho do BPB
+//   ROB_SIZE     entradas do ROB (de cada thread no SMT)
+//   CPU_FREQ     frequencia em MHz usada nas metricas
+//   RS_ADD, RS_MUL, RS_LOAD  estacoes de reserva de cada classe ('-r')
+//   LAT_<INSTR>  latencia da instrucao, como no '-l' (LAT_MEM para load/store)
+// "PRESET nome" herda os valores do preset nome.txt, procurado primeiro na
+// pasta do arquivo e depois na pasta de presets; as linhas seguintes
+// sobrescrevem o que foi herdado. Os presets podem herdar de outros.
+// Toda chave e conferida contra a tabela de limites; chaves desconhecidas,
+// valores fora dos limites e heranca circular sao erros com arquivo e linha.
+// Depois da leitura as chaves sao conferidas entre si (FU_* e CLUSTERS,
+// VWIDTH e VLEN, RS_LIMIT_* e RS_TOTAL, geometria da cache de dados); o erro
+// aponta a chave e a linha em que recebeu o valor.
+// Chaves de texto registradas com add_text_key (os arquivos de um projeto)
+// aceitam um valor nao numerico.
+// Nao depende da interface, para ser usada com ou sem ela.
+class machine_config
+{
+public:
+    machine_config(string preset_dir);
+    // Le a descricao; retorna false se houve algum erro
+    bool load(string path);
+    // Le um arquivo de latencias do '-l' ("<INSTR> <latencia>" por linha),
+    // com as mesmas regras e limites das chaves LAT_
+    bool load_latencies(string path);
+    // Confere valores que nao vieram de um arquivo de texto (uma imagem
+    // binaria, por exemplo) com os mesmos limites e conferencias; where
+    // identifica a origem nas mensagens
+    bool load_values(const map<string,int> &v, string where);
+    const vector<string> &get_errors();
+    bool has(string key);
+    int get(string key);
+    // Parametros do modo com especulacao (com ROB_SIZE), sem as chaves
+    // aplicadas pela interface
+    map<string,int> get_config();
+    // Latencias por instrucao (chaves LAT_ sem o prefixo)
+    map<string,int> get_latencies();
+    // Aceita key com valor de texto; se path, o valor e um caminho relativo
+    // a pasta do arquivo em que aparece
+    void add_text_key(string key, bool path);
+    bool has_text(string key);
+    string get_text(string key);
+
+private:
+    string preset_dir;
+    map<string,int> values;
+    map<string,bool> text_keys;
+    map<string,string> texts;
+    map<string,string> origin; //"arquivo:linha" em que cada chave recebeu o valor
+    vector<string> errors;
+    vector<string> loading; //arquivos sendo lidos, para achar heranca circular
+    // Valores aceitos de cada chave
+    static const map<string,pair<int,int>> limits;
+
+    bool read(string path, string where, string prefix);
+    void set(string key, long v, string here);
+    void check();
+    void conflict(string key, string other, string reason);
+    static bool machine_key(string key);
+};
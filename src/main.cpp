@@ -11,6 +11,9 @@
 #include<nana/gui/filebox.hpp>
 #include "top.hpp"
 #include "gui.hpp"
+#include "assembler.hpp"
+#include "program_image.hpp"
+#include "machine_config.hpp"
 #include <unistd.h>
 #include <libgen.h>
 
@@ -60,7 +63,6 @@ int sc_main(int argc, char *argv[])
     n_bits = 2;
     bpb_size = 4;
     cpu_freq = 500; // definido em Mhz - 500Mhz default
-    std::vector<int> sizes;
     bool spec = false;
     int mode = 0;
     bool fila = false;
@@ -87,11 +89,15 @@ int sc_main(int argc, char *argv[])
     clock_group.caption("Ciclo");
     clock_group.div("count");
     grid memory(fm,rectangle(),10,50);
+    int mem_rows = 10; //linhas de 50 palavras na memoria
     // Tempo de latencia de uma instrucao
     // Novas instrucoes devem ser inseridas manualmente aqui
     map<string,int> instruct_time{{"DADD",4},{"DADDI",4},{"DSUB",6},
     {"DSUBI",6},{"DMUL",10},{"DDIV",16},{"MEM",2},
-    {"SLT",1},{"SGT", 1}};
+    {"SLT",1},{"SGT", 1},{"DFMA",12}};
+    // Parametros da microarquitetura do modo com especulacao (-c)
+    // Chaves ausentes valem 0, que mantem o comportamento original
+    map<string,int> config;
     // Responsavel pelos modos de execução
     top top1("top");
     raw.caption("RAW");
@@ -116,6 +122,192 @@ int sc_main(int argc, char *argv[])
     set_spec(plc,spec);
     plc.collocate();
 
+    std::string base_path = std::string(get_base_path((const char **)argv));
+
+    auto show_errors = [&](string title, const vector<string> &err)
+    {
+        string msg;
+        for(unsigned int i = 0 ; i < err.size() && i < 10 ; i++)
+            msg += err[i] + "\n";
+        if(err.size() > 10)
+            msg += "... (" + std::to_string(err.size()) + " erros)";
+        show_message(title,msg);
+    };
+
+    // Arquivos de texto da fila, dos registradores e da memoria, usados pelos
+    // menus, pela linha de comando e pelos projetos
+    auto load_queue = [&](string path)
+    {
+        ifstream in(path);
+        if(!add_instructions(in,instruction_queue,instruct))
+        {
+            show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
+            return false;
+        }
+        fila = true;
+        return true;
+    };
+    auto load_int_regs = [&](string path)
+    {
+        ifstream in(path);
+        if(!in.is_open())
+        {
+            show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
+            return false;
+        }
+        auto reg_gui = reg.at(0);
+        int value,i = 0;
+        while(in >> value && i < 32)
+        {
+            reg_gui.at(i).text(1,std::to_string(value));
+            i++;
+        }
+        for(; i < 32 ; i++)
+            reg_gui.at(i).text(1,"0");
+        return true;
+    };
+    auto load_fp_regs = [&](string path)
+    {
+        ifstream in(path);
+        if(!in.is_open())
+        {
+            show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
+            return false;
+        }
+        auto reg_gui = reg.at(0);
+        int i = 0;
+        float value;
+        while(in >> value && i < 32)
+        {
+            reg_gui.at(i).text(4,std::to_string(value));
+            i++;
+        }
+        for(; i < 32 ; i++)
+            reg_gui.at(i).text(4,"0");
+        return true;
+    };
+    auto load_memory = [&](string path)
+    {
+        ifstream in(path);
+        if(!in.is_open())
+        {
+            show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
+            return false;
+        }
+        int value,i = 0;
+        while(in >> value && i < mem_rows*50)
+        {
+            memory.Set(i,std::to_string(value));
+            i++;
+        }
+        for(; i < mem_rows*50 ; i++)
+            memory.Set(i,"0");
+        return true;
+    };
+
+    // Programa em assembly: monta e carrega as instrucoes e, se houver secao
+    // .data, a memoria (que cresce alem das 500 palavras se preciso)
+    auto load_asm = [&](string path)
+    {
+        ifstream src(path);
+        assembler as;
+        if(!src.is_open())
+        {
+            show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
+            return false;
+        }
+        if(!as.assemble(src))
+        {
+            show_errors("Erro de montagem",as.get_errors());
+            return false;
+        }
+        add_instructions(as.get_program(),instruction_queue,instruct);
+        fila = true;
+        const vector<int> &data = as.get_data();
+        if(data.size())
+        {
+            int rows = (data.size()+49)/50;
+            if(rows > mem_rows)
+            {
+                memory.Resize(rows,50);
+                mem_rows = rows;
+            }
+            for(int i = 0 ; i < mem_rows*50 ; i++)
+                memory.Set(i,i < (int)data.size() ? std::to_string(data[i]) : "0");
+        }
+        //Programa montado no log, no formato da fila de instrucoes
+        as.write_program(cout);
+        return true;
+    };
+
+    // Imagem binaria (-b): programa, registradores, memoria e configuracao
+    // lidos do arquivo mapeado; secoes vazias mantem os valores atuais
+    //Estacoes, latencias e configuracao da imagem passam pelos limites da
+    //descricao da maquina; retorna os erros encontrados
+    auto check_image = [&](program_image &img, string path)
+    {
+        if(!img.open(path))
+            return vector<string>{path + ": " + img.get_error()};
+        map<string,int> values = img.get_config();
+        const char *rs[3] = {"RS_ADD","RS_MUL","RS_LOAD"};
+        for(unsigned int i = 0 ; i < 3 ; i++)
+            if(img.get_stations(i))
+                values[rs[i]] = img.get_stations(i);
+        for(auto &l : img.get_latencies())
+            values["LAT_" + l.first] = l.second;
+        machine_config mc(base_path + "/in/presets");
+        mc.load_values(values,path);
+        return mc.get_errors();
+    };
+    auto load_image = [&](string path)
+    {
+        //Com algum erro nada da imagem e aplicado
+        program_image img;
+        vector<string> err = check_image(img,path);
+        if(err.size())
+        {
+            show_errors("Imagem inválida",err);
+            return false;
+        }
+        vector<string> program = img.get_program();
+        if(program.size())
+        {
+            add_instructions(program,instruction_queue,instruct);
+            fila = true;
+        }
+        auto reg_gui = reg.at(0);
+        const int32_t *int_regs = img.get_int_regs();
+        const float *fp_regs = img.get_fp_regs();
+        for(unsigned int i = 0 ; img.get_int_count() && i < 32 ; i++)
+            reg_gui.at(i).text(1,std::to_string(i < img.get_int_count() ? int_regs[i] : 0));
+        for(unsigned int i = 0 ; img.get_fp_count() && i < 32 ; i++)
+            reg_gui.at(i).text(4,std::to_string(i < img.get_fp_count() ? fp_regs[i] : 0.0f));
+        const int32_t *mem = img.get_memory();
+        int words = img.get_memory_size();
+        if(words)
+        {
+            int rows = (words+49)/50;
+            if(rows > mem_rows)
+            {
+                memory.Resize(rows,50);
+                mem_rows = rows;
+            }
+            for(int i = 0 ; i < mem_rows*50 ; i++)
+                memory.Set(i,i < words ? std::to_string(mem[i]) : "0");
+        }
+        if(img.get_stations(0))
+            nadd = img.get_stations(0);
+        if(img.get_stations(1))
+            nmul = img.get_stations(1);
+        if(img.get_stations(2))
+            nls = img.get_stations(2);
+        for(auto &l : img.get_latencies())
+            instruct_time[l.first] = l.second;
+        for(auto &c : img.get_config())
+            config[c.first] = c.second;
+        return true;
+    };
+
     mnbar.push_back("Opções");
     menu &op = mnbar.at(0);
     //menu::item_proxy spec_ip = 
@@ -154,6 +346,180 @@ int sc_main(int argc, char *argv[])
     spec_sub->check_style(0,menu::checks::highlight);
     spec_sub->check_style(1,menu::checks::highlight);
 
+    // Descricao da maquina (-c): todos os parametros num arquivo, com heranca
+    // dos presets de in/presets; so as chaves presentes mudam os valores atuais
+    auto apply_machine = [&](machine_config &mc)
+    {
+        if(mc.has("RS_ADD"))
+            nadd = mc.get("RS_ADD");
+        if(mc.has("RS_MUL"))
+            nmul = mc.get("RS_MUL");
+        if(mc.has("RS_LOAD"))
+            nls = mc.get("RS_LOAD");
+        if(mc.has("PRED_BITS"))
+            n_bits = mc.get("PRED_BITS");
+        if(mc.has("BPB_SIZE"))
+            bpb_size = mc.get("BPB_SIZE");
+        if(mc.has("CPU_FREQ"))
+            cpu_freq = mc.get("CPU_FREQ");
+        if(mc.has("MODE"))
+        {
+            mode = mc.get("MODE");
+            spec = mode > 0;
+            spec_sub->checked(0,mode == 1);
+            spec_sub->checked(1,mode == 2);
+            set_spec(plc,spec);
+        }
+        for(auto &l : mc.get_latencies())
+            instruct_time[l.first] = l.second;
+        for(auto &c : mc.get_config())
+            config[c.first] = c.second;
+    };
+    auto load_machine = [&](string path)
+    {
+        machine_config mc(base_path + "/in/presets");
+        if(!mc.load(path))
+            show_errors("Erro na descrição da máquina",mc.get_errors());
+        else
+            apply_machine(mc);
+    };
+
+    // Projeto (-p): descricao da maquina com os arquivos de um experimento;
+    // os caminhos sao relativos a pasta do projeto. A maquina parte do preset
+    // base, e um projeto com qualquer erro nao e carregado
+    auto load_project = [&](string path)
+    {
+        machine_config mc(base_path + "/in/presets");
+        machine_config base(base_path + "/in/presets");
+        const vector<string> files = {"IMAGEM","ASSEMBLY","PROGRAMA","REGS","REGS_PF","MEMORIA"};
+        for(unsigned int i = 0 ; i < files.size() ; i++)
+            mc.add_text_key(files[i],true);
+        mc.add_text_key("METRICAS",false);
+        vector<string> err;
+        if(!mc.load(path))
+            err = mc.get_errors();
+        else if(!base.load(base_path + "/in/presets/base.txt"))
+            err = base.get_errors();
+        //Os arquivos sao conferidos antes de mudar qualquer valor
+        for(unsigned int i = 0 ; err.empty() && i < files.size() ; i++)
+        {
+            string file = mc.get_text(files[i]);
+            if(!mc.has_text(files[i]))
+                continue;
+            ifstream in(file);
+            if(!in.is_open())
+                err.push_back(path + ": " + files[i] + " " + file + " nao encontrado");
+            else if(files[i] == "ASSEMBLY")
+            {
+                assembler as;
+                if(!as.assemble(in))
+                    for(auto &e : as.get_errors())
+                        err.push_back(file + ": " + e);
+            }
+            else if(files[i] == "IMAGEM")
+            {
+                program_image img;
+                for(auto &e : check_image(img,file))
+                    err.push_back(e);
+            }
+        }
+        if(err.size())
+        {
+            show_errors("Erro no projeto",err);
+            return false;
+        }
+        config.clear();
+        apply_machine(base);
+        apply_machine(mc);
+        bool ok = true;
+        if(mc.has_text("IMAGEM"))
+            ok = load_image(mc.get_text("IMAGEM")) && ok;
+        if(mc.has_text("ASSEMBLY"))
+            ok = load_asm(mc.get_text("ASSEMBLY")) && ok;
+        if(mc.has_text("PROGRAMA"))
+            ok = load_queue(mc.get_text("PROGRAMA")) && ok;
+        if(mc.has_text("REGS"))
+            ok = load_int_regs(mc.get_text("REGS")) && ok;
+        if(mc.has_text("REGS_PF"))
+            ok = load_fp_regs(mc.get_text("REGS_PF")) && ok;
+        if(mc.has_text("MEMORIA"))
+            ok = load_memory(mc.get_text("MEMORIA")) && ok;
+        bench_name = mc.get_text("METRICAS");
+        return ok;
+    };
+
+    // Grava o estado atual (fila, registradores, memoria e configuracao) numa
+    // imagem para o '-b'
+    auto save_image = [&](string path)
+    {
+        //Celulas editadas na interface podem nao ser numeros; com algum erro
+        //a imagem nao e gravada
+        vector<string> err;
+        auto cell = [&](string text, string name, bool fp)
+        {
+            size_t used = 0;
+            double v = 0;
+            try
+            {
+                v = fp ? std::stof(text,&used) : std::stoi(text,&used);
+            }
+            catch(...)
+            {
+                used = 0;
+            }
+            if(!used || used != text.size())
+                err.push_back(name + ": valor \"" + text + "\" nao e " + (fp ? "um numero" : "inteiro"));
+            return v;
+        };
+        auto reg_gui = reg.at(0);
+        vector<int32_t> int_regs,mem;
+        vector<float> fp_regs;
+        for(int i = 0 ; i < 32 ; i++)
+        {
+            int_regs.push_back(cell(reg_gui.at(i).text(1),"R" + std::to_string(i),false));
+            fp_regs.push_back(cell(reg_gui.at(i).text(4),"F" + std::to_string(i),true));
+        }
+        for(int i = 0 ; i < mem_rows*50 ; i++)
+            mem.push_back(cell(memory.Get(i),"memoria[" + std::to_string(i) + "]",false));
+        if(err.size())
+        {
+            show_errors("Valores inválidos",err);
+            return false;
+        }
+        unsigned int stations[3] = {(unsigned int)nadd,(unsigned int)nmul,(unsigned int)nls};
+        if(!program_image::write(path,instruction_queue,int_regs,fp_regs,mem,stations,config,instruct_time))
+        {
+            show_message("Arquivo inválido","Não foi possível gravar a imagem!");
+            return false;
+        }
+        return true;
+    };
+
+    // Salva o projeto: a imagem com o estado ao lado do arquivo do projeto,
+    // que guarda tambem o modo, o preditor, a frequencia e as metricas
+    auto save_project = [&](string path)
+    {
+        size_t slash = path.find_last_of('/');
+        size_t dot = path.find_last_of('.');
+        string stem = dot != string::npos && (slash == string::npos || dot > slash) ? path.substr(0,dot) : path;
+        if(!save_image(stem + ".img"))
+            return;
+        std::ofstream out(path);
+        if(!out.is_open())
+        {
+            show_message("Arquivo inválido","Não foi possível gravar o projeto!");
+            return;
+        }
+        out << "# Projeto do TFSim" << endl;
+        out << "IMAGEM " << stem.substr(slash == string::npos ? 0 : slash+1) << ".img" << endl;
+        out << "MODE " << mode << endl;
+        out << "PRED_BITS " << n_bits << endl;
+        out << "BPB_SIZE " << bpb_size << endl;
+        out << "CPU_FREQ " << cpu_freq << endl;
+        if(bench_name != "")
+            out << "METRICAS " << bench_name << endl;
+    };
+
     op.append("Modificar valores...");
     // novo submenu para escolha do tamanho do bpb e do preditor
     auto sub = op.create_sub_menu(1);
@@ -170,9 +536,9 @@ int sc_main(int argc, char *argv[])
     sub->append("Número de Estações de Reserva",[&](menu::item_proxy ip)
     {
         inputbox ibox(fm,"","Quantidade de Estações de Reserva");
-        inputbox::integer add("ADD/SUB",nadd,1,10,1);
-        inputbox::integer mul("MUL/DIV",nmul,1,10,1);
-        inputbox::integer sl("LOAD/STORE",nls,1,10,1);
+        inputbox::integer add("ADD/SUB",nadd,1,64,1);
+        inputbox::integer mul("MUL/DIV",nmul,1,64,1);
+        inputbox::integer sl("LOAD/STORE",nls,1,64,1);
         if(ibox.show_modal(add,mul,sl))
         {
             nadd = add.value();
@@ -191,8 +557,9 @@ int sc_main(int argc, char *argv[])
         inputbox::text dsubi_t("DSUBI",std::to_string(instruct_time["DSUBI"]));
         inputbox::text dmul_t("DMUL",std::to_string(instruct_time["DMUL"]));
         inputbox::text ddiv_t("DDIV",std::to_string(instruct_time["DDIV"]));
+        inputbox::text dfma_t("DFMA",std::to_string(instruct_time["DFMA"]));
         inputbox::text mem_t("Load/Store",std::to_string(instruct_time["MEM"]));
-        if(ibox.show_modal(dadd_t,daddi_t,dsub_t,dsubi_t,dmul_t,ddiv_t,mem_t))
+        if(ibox.show_modal(dadd_t,daddi_t,dsub_t,dsubi_t,dmul_t,ddiv_t,dfma_t,mem_t))
         {
             instruct_time["DADD"] = std::stoi(dadd_t.value());
             instruct_time["DADDI"] = std::stoi(daddi_t.value());
@@ -200,6 +567,7 @@ int sc_main(int argc, char *argv[])
             instruct_time["DSUBI"] = std::stoi(dsubi_t.value());
             instruct_time["DMUL"] = std::stoi(dmul_t.value());
             instruct_time["DDIV"] = std::stoi(ddiv_t.value());
+            instruct_time["DFMA"] = std::stoi(dfma_t.value());
             instruct_time["MEM"] = std::stoi(mem_t.value());
         }
     });
@@ -219,14 +587,31 @@ int sc_main(int argc, char *argv[])
         inputbox ibox(fm,"Localização do arquivo com a lista de instruções:");
         inputbox::path caminho("",fb);
         if(ibox.show_modal(caminho))
-        {
-            auto path = caminho.value();
-            inFile.open(path);
-            if(!add_instructions(inFile,instruction_queue,instruct))
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-                fila = true;
-        }
+            load_queue(caminho.value());
+    });
+    sub->append("Programa em assembly", [&](menu::item_proxy &ip)
+    {
+        filebox fb(0,true);
+        inputbox ibox(fm,"Localização do programa em assembly (rótulos, .text e .data):");
+        inputbox::path caminho("",fb);
+        if(ibox.show_modal(caminho))
+            load_asm(caminho.value());
+    });
+    sub->append("Imagem binária",[&](menu::item_proxy &ip)
+    {
+        filebox fb(0,true);
+        inputbox ibox(fm,"Localização da imagem (programa, registradores, memória e configuração):");
+        inputbox::path caminho("",fb);
+        if(ibox.show_modal(caminho))
+            load_image(caminho.value());
+    });
+    sub->append("Descrição da máquina",[&](menu::item_proxy &ip)
+    {
+        filebox fb(0,true);
+        inputbox ibox(fm,"Localização da descrição da máquina (<CHAVE> <valor> e PRESET <nome>):");
+        inputbox::path caminho("",fb);
+        if(ibox.show_modal(caminho))
+            load_machine(caminho.value());
     });
     sub->append("Valores de registradores inteiros",[&](menu::item_proxy &ip)
     {
@@ -234,25 +619,7 @@ int sc_main(int argc, char *argv[])
         inputbox ibox(fm,"Localização do arquivo de valores de registradores inteiros:");
         inputbox::path caminho("",fb);
         if(ibox.show_modal(caminho))
-        {
-            auto path = caminho.value();
-            inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                auto reg_gui = reg.at(0);
-                int value,i = 0;
-                while(inFile >> value && i < 32)
-                {
-                    reg_gui.at(i).text(1,std::to_string(value));
-                    i++;
-                }
-                for(; i < 32 ; i++)
-                    reg_gui.at(i).text(1,"0");
-                inFile.close();
-            }
-        }
+            load_int_regs(caminho.value());
     });
     sub->append("Valores de registradores PF",[&](menu::item_proxy &ip)
     {
@@ -260,26 +627,7 @@ int sc_main(int argc, char *argv[])
         inputbox ibox(fm,"Localização do arquivo de valores de registradores PF:");
         inputbox::path caminho("",fb);
         if(ibox.show_modal(caminho))
-        {
-            auto path = caminho.value();
-            inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                auto reg_gui = reg.at(0);
-                int i = 0;
-                float value;
-                while(inFile >> value && i < 32)
-                {
-                    reg_gui.at(i).text(4,std::to_string(value));
-                    i++;
-                }
-                for(; i < 32 ; i++)
-                    reg_gui.at(i).text(4,"0");
-                inFile.close();
-            }
-        }
+            load_fp_regs(caminho.value());
     });
     sub->append("Valores de memória",[&](menu::item_proxy &ip)
     {
@@ -287,27 +635,7 @@ int sc_main(int argc, char *argv[])
         inputbox ibox(fm,"Localização do arquivo de valores de memória:");
         inputbox::path caminho("",fb);
         if(ibox.show_modal(caminho))
-        {
-            auto path = caminho.value();
-            inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                int i = 0;
-                int value;
-                while(inFile >> value && i < 500)
-                {
-                    memory.Set(i,std::to_string(value));
-                    i++;
-                }
-                for(; i < 500 ; i++)
-                {
-                    memory.Set(i,"0");
-                }
-                inFile.close();
-            }
-        }
+            load_memory(caminho.value());
     });
     op.append("Verificar conteúdo...");
     auto new_sub = op.create_sub_menu(2);
@@ -421,329 +749,57 @@ int sc_main(int argc, char *argv[])
         }
     });
     op.append("Benchmarks");
-    std::string base_path = std::string(get_base_path((const char **)argv));
     auto bench_sub = op.create_sub_menu(3);
-    bench_sub->append("Fibonacci",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/fibonacci/fibonacci.txt";
-        bench_name = "fibonacci";        
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-        else
-            fila = true;
-    });
-    bench_sub->append("Stall por Divisão",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/division_stall.txt";       
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-        else
-            fila = true;
-    });
-    bench_sub->append("Stress de Memória (Stores)",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/store_stress/store_stress.txt";   
-        bench_name = "store_stress";  
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-        else
-            fila = true;
-    });
-    bench_sub->append("Stall por hazard estrutural (Adds)",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/res_stations_stall.txt";       
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-        else
-            fila = true;
-    }); 
-    bench_sub->append("Busca Linear",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/linear_search/linear_search.txt";
-        bench_name = "linear_search";
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo");
-        else
-            fila = true;
-        
-        path = base_path + "/in/benchmarks/linear_search/memory.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                int i = 0;
-                int value;
-                while(inFile >> value && i < 500)
-                {
-                    memory.Set(i,std::to_string(value));
-                    i++;
-                }
-                for(; i < 500 ; i++)
-                {
-                    memory.Set(i,"0");
-                }
-                inFile.close();
-            }
-
-        path = base_path + "/in/benchmarks/linear_search/regi_i.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                auto reg_gui = reg.at(0);
-                int value,i = 0;
-                while(inFile >> value && i < 32)
-                {
-                    reg_gui.at(i).text(1,std::to_string(value));
-                    i++;
-                }
-                for(; i < 32 ; i++)
-                    reg_gui.at(i).text(1,"0");
-                inFile.close();
-            }
-    });
-
-    bench_sub->append("Busca Binária",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/binary_search/binary_search.txt";
-        bench_name = "binary_search";
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo");
-        else
-            fila = true;
-        
-        path = base_path + "/in/benchmarks/binary_search/memory.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                int i = 0;
-                int value;
-                while(inFile >> value && i < 500)
-                {
-                    memory.Set(i,std::to_string(value));
-                    i++;
-                }
-                for(; i < 500 ; i++)
-                {
-                    memory.Set(i,"0");
-                }
-                inFile.close();
-            }
-
-        path = base_path + "/in/benchmarks/binary_search/regs.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                auto reg_gui = reg.at(0);
-                int value,i = 0;
-                while(inFile >> value && i < 32)
-                {
-                    reg_gui.at(i).text(1,std::to_string(value));
-                    i++;
-                }
-                for(; i < 32 ; i++)
-                    reg_gui.at(i).text(1,"0");
-                inFile.close();
-            }
-    });
-
-    bench_sub->append("Matriz Search",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/matriz_search/matriz_search.txt";
-        bench_name = "matriz_search";
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo");
-        else
-            fila = true;
-        
-        path = base_path + "/in/benchmarks/matriz_search/memory.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                int i = 0;
-                int value;
-                while(inFile >> value && i < 500)
-                {
-                    memory.Set(i,std::to_string(value));
-                    i++;
-                }
-                for(; i < 500 ; i++)
-                {
-                    memory.Set(i,"0");
-                }
-                inFile.close();
-            }
-
-        path = base_path + "/in/benchmarks/matriz_search/regs.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                auto reg_gui = reg.at(0);
-                int value,i = 0;
-                while(inFile >> value && i < 32)
-                {
-                    reg_gui.at(i).text(1,std::to_string(value));
-                    i++;
-                }
-                for(; i < 32 ; i++)
-                    reg_gui.at(i).text(1,"0");
-                inFile.close();
-            }
-    });
-
-    bench_sub->append("Bubble Sort",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/bubble_sort/bubble_sort.txt";
-        bench_name = "bubble_sort";
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo");
-        else
-            fila = true;
-        
-        path = base_path + "/in/benchmarks/bubble_sort/memory.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                int i = 0;
-                int value;
-                while(inFile >> value && i < 500)
-                {
-                    memory.Set(i,std::to_string(value));
-                    i++;
-                }
-                for(; i < 500 ; i++)
-                {
-                    memory.Set(i,"0");
-                }
-                inFile.close();
-            }
-
-        path = base_path + "/in/benchmarks/bubble_sort/regs.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                auto reg_gui = reg.at(0);
-                int value,i = 0;
-                while(inFile >> value && i < 32)
-                {
-                    reg_gui.at(i).text(1,std::to_string(value));
-                    i++;
-                }
-                for(; i < 32 ; i++)
-                    reg_gui.at(i).text(1,"0");
-                inFile.close();
-            }
-    });
-
-    bench_sub->append("Insertion Sort",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/insertion_sort/insertion_sort.txt";
-        bench_name = "insertion_sort";
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo");
-        else
-            fila = true;
-        
-        path = base_path + "/in/benchmarks/insertion_sort/memory.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                int i = 0;
-                int value;
-                while(inFile >> value && i < 500)
-                {
-                    memory.Set(i,std::to_string(value));
-                    i++;
-                }
-                for(; i < 500 ; i++)
-                {
-                    memory.Set(i,"0");
-                }
-                inFile.close();
-            }
-
-        path = base_path + "/in/benchmarks/insertion_sort/regs.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                auto reg_gui = reg.at(0);
-                int value,i = 0;
-                while(inFile >> value && i < 32)
-                {
-                    reg_gui.at(i).text(1,std::to_string(value));
-                    i++;
-                }
-                for(; i < 32 ; i++)
-                    reg_gui.at(i).text(1,"0");
-                inFile.close();
-            }
+    // Cada benchmark e um projeto em in/benchmarks
+    const vector<std::pair<string,string>> benchmarks = {
+        {"Fibonacci","fibonacci/fibonacci.tfp"},
+        {"Stall por Divisão","division_stall.tfp"},
+        {"Stress de Memória (Stores)","store_stress/store_stress.tfp"},
+        {"Stall por hazard estrutural (Adds)","res_stations_stall.tfp"},
+        {"Seleção por Dependentes","dependents_select.tfp"},
+        {"Prioridade no CDB","cdb_priority.tfp"},
+        {"Busca Linear","linear_search/linear_search.tfp"},
+        {"Busca Linear (LOOP)","linear_search/linear_search_loop.tfp"},
+        {"Busca Linear (PREF)","linear_search/linear_search_pref.tfp"},
+        {"Busca Linear (assembly)","linear_search/linear_search_asm.tfp"},
+        {"Busca Binária","binary_search/binary_search.tfp"},
+        {"Busca Binária (CMOV)","binary_search/binary_search_cmov.tfp"},
+        {"Matriz Search","matriz_search/matriz_search.tfp"},
+        {"Matriz Search (LOOP)","matriz_search/matriz_search_loop.tfp"},
+        {"Matriz Search (SIMD)","matriz_search/matriz_search_simd.tfp"},
+        {"Bubble Sort","bubble_sort/bubble_sort.tfp"},
+        {"Bubble Sort (LOOP)","bubble_sort/bubble_sort_loop.tfp"},
+        {"Bubble Sort (CMOV)","bubble_sort/bubble_sort_cmov.tfp"},
+        {"Insertion Sort","insertion_sort/insertion_sort.tfp"},
+        {"Insertion Sort (LOOP)","insertion_sort/insertion_sort_loop.tfp"},
+        {"Tick Tack","tick_tack/tick_tack.tfp"}};
+    for(unsigned int b = 0 ; b < benchmarks.size() ; b++)
+    {
+        string path = base_path + "/in/benchmarks/" + benchmarks[b].second;
+        bench_sub->append(benchmarks[b].first,[&,path](menu::item_proxy &ip){
+            load_project(path);
+        });
+    }
+    op.append("Projeto");
+    auto proj_sub = op.create_sub_menu(4);
+    proj_sub->append("Abrir projeto",[&](menu::item_proxy &ip)
+    {
+        filebox fb(0,true);
+        inputbox ibox(fm,"Localização do projeto:");
+        inputbox::path caminho("",fb);
+        if(ibox.show_modal(caminho))
+            load_project(caminho.value());
     });
-
-    bench_sub->append("Tick Tack",[&](menu::item_proxy &ip){
-        string path = base_path + "/in/benchmarks/tick_tack/tick_tack.txt";
-        bench_name = "tick_tack";
-        inFile.open(path);
-        if(!add_instructions(inFile,instruction_queue,instruct))
-            show_message("Arquivo inválido","Não foi possível abrir o arquivo");
-        else
-            fila = true;
-        
-        path = base_path + "/in/benchmarks/tick_tack/regs.txt";
-        inFile.open(path);
-            if(!inFile.is_open())
-                show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-            else
-            {
-                auto reg_gui = reg.at(0);
-                int value,i = 0;
-                while(inFile >> value && i < 32)
-                {
-                    reg_gui.at(i).text(1,std::to_string(value));
-                    i++;
-                }
-                for(; i < 32 ; i++)
-                    reg_gui.at(i).text(1,"0");
-                inFile.close();
-            }
+    proj_sub->append("Salvar projeto",[&](menu::item_proxy &ip)
+    {
+        filebox fb(0,false);
+        inputbox ibox(fm,"Arquivo do projeto (a imagem é gravada ao lado, com extensão .img):");
+        inputbox::path caminho("",fb);
+        if(ibox.show_modal(caminho))
+            save_project(caminho.value());
     });
 
-    vector<string> columns = {"#","Name","Busy","Op","Vj","Vk","Qj","Qk","A"}; 
-    for(unsigned int i = 0 ; i < columns.size() ; i++)
-    {
-        table.append_header(columns[i].c_str());
-        if(i && i != 3)
-            table.column_at(i).width(45);
-        else if (i == 3)
-            table.column_at(i).width(60);
-        else
-            table.column_at(i).width(30);
-    }
-    columns = {"","Value","Qi"};
-    sizes = {30,75,40};
-    for(unsigned int k = 0 ; k < 2 ; k++)
-        for(unsigned int i = 0 ; i < columns.size() ; i++)
-        {
-            reg.append_header(columns[i]);
-            reg.column_at(k*columns.size() + i).width(sizes[i]);
-        }
+    set_headers(table,reg,instruct,rob);
 
     auto reg_gui = reg.at(0);
     for(int i = 0 ; i < 32 ;i++)
@@ -751,21 +807,7 @@ int sc_main(int argc, char *argv[])
         string index = std::to_string(i);
         reg_gui.append("R" + index);
         reg_gui.at(i).text(3,"F" + index);
-    }
-
-    columns = {"Instruction","Issue","Execute","Write Result"};
-    sizes = {140,60,70,95};
-    for(unsigned int i = 0 ; i < columns.size() ; i++)
-    {
-        instruct.append_header(columns[i]);
-        instruct.column_at(i).width(sizes[i]);
-    }
-    columns = {"Entry","Busy","Instruction","State","Destination","Value"};
-    sizes = {45,45,120,120,90,60};
-    for(unsigned int i = 0 ; i < columns.size() ; i++)
-    {
-        rob.append_header(columns[i]);
-        rob.column_at(i).width(sizes[i]);
+        reg_gui.at(i).text(6,"V" + index);
     }
 
     srand(static_cast <unsigned> (time(0)));
@@ -778,12 +820,15 @@ int sc_main(int argc, char *argv[])
         reg_gui.at(i).text(2,"0");
         reg_gui.at(i).text(4,std::to_string(static_cast <float> (rand()) / static_cast <float> (RAND_MAX/100.0)));
         reg_gui.at(i).text(5,"0");
+        reg_gui.at(i).text(7,"0");
+        reg_gui.at(i).text(8,"0");
     }
     for(int i = 0 ; i < 500 ; i++)
         memory.Push(std::to_string(rand()%100));
+    string image_out = "";
+    string project_out = "";
     for(int k = 1; k < argc; k+=2)
     {
-        int i;
         if (strlen(argv[k]) > 2)
             show_message("Opção inválida",string("Opção \"") + string(argv[k]) + string("\" inválida"));
         else
@@ -792,67 +837,31 @@ int sc_main(int argc, char *argv[])
             switch(c)
             {
                 case 'q':
-                    inFile.open(argv[k+1]);
-                    if(!add_instructions(inFile,instruction_queue,instruct))
-                        show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-                    else
-                        fila = true;
+                    load_queue(argv[k+1]);
+                    break;
+                case 'a':
+                    load_asm(argv[k+1]);
+                    break;
+                case 'b':
+                    load_image(argv[k+1]);
+                    break;
+                case 'g':
+                    image_out = argv[k+1];
+                    break;
+                case 'p':
+                    load_project(argv[k+1]);
+                    break;
+                case 'o':
+                    project_out = argv[k+1];
                     break;
                 case 'i':
-                    inFile.open(argv[k+1]);
-                    int value;
-                    i = 0;
-                    if(!inFile.is_open())
-                        show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-                    else
-                    {
-                        while(inFile >> value && i < 32)
-                        {
-                            reg_gui.at(i).text(1,std::to_string(value));
-                            i++;
-                        }
-                        for(; i < 32 ; i++)
-                            reg_gui.at(i).text(1,"0");
-                        inFile.close();
-                    }
+                    load_int_regs(argv[k+1]);
                     break;
                 case 'f':
-                    float value_fp;
-                    i = 0;
-                    inFile.open(argv[k+1]);
-                    if(!inFile.is_open())
-                        show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-                    else
-                    {
-                        while(inFile >> value_fp && i < 32)
-                        {
-                            reg_gui.at(i).text(4,std::to_string(value_fp));
-                            i++;
-                        }
-                        for(; i < 32 ; i++)
-                            reg_gui.at(i).text(4,"0");
-                        inFile.close();
-                    }
+                    load_fp_regs(argv[k+1]);
                     break;
                 case 'm':
-                    inFile.open(argv[k+1]);
-                    if(!inFile.is_open())
-                        show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
-                    else
-                    {
-                        int value;
-                        i = 0;
-                        while(inFile >> value && i < 500)
-                        {
-                            memory.Set(i,std::to_string(value));
-                            i++;
-                        }
-                        for(; i < 500 ; i++)
-                        {
-                            memory.Set(i,"0");
-                        }
-                        inFile.close();
-                    }
+                    load_memory(argv[k+1]);
                     break;
                 case 'r':
                     inFile.open(argv[k+1]);
@@ -861,11 +870,11 @@ int sc_main(int argc, char *argv[])
                     else
                     {
                         int value;
-                        if(inFile >> value && value <= 10 && value > 0)
+                        if(inFile >> value && value <= 64 && value > 0)
                             nadd = value;
-                        if(inFile >> value && value <= 10 && value > 0)
+                        if(inFile >> value && value <= 64 && value > 0)
                             nmul = value;
-                        if(inFile >> value && value <= 10 && value > 0)
+                        if(inFile >> value && value <= 64 && value > 0)
                             nls = value;
                         inFile.close();
                     }
@@ -877,21 +886,36 @@ int sc_main(int argc, char *argv[])
                     k--;
                     break;
                 case 'l':
+                {
+                    //Mesmo parser e limites das chaves LAT_ da descricao da maquina
+                    machine_config mc(base_path + "/in/presets");
+                    if(!mc.load_latencies(argv[k+1]))
+                        show_errors("Erro nas latências",mc.get_errors());
+                    else
+                        for(auto &l : mc.get_latencies())
+                            instruct_time[l.first] = l.second;
+                    break;
+                }
+                case 't':
                     inFile.open(argv[k+1]);
                     if(!inFile.is_open())
                         show_message("Arquivo inválido","Não foi possível abrir o arquivo!");
                     else
                     {
-                        string inst;
-                        int value;
-                        while(inFile >> inst)
-                        {
-                            if(inFile >> value && instruct_time.count(inst))
-                                instruct_time[inst] = value;
-                        }
+                        //Programa de mais uma thread do SMT (SMT_THREADS na configuracao)
+                        //ou de mais um nucleo (CORES)
+                        vector<string> program;
+                        string line;
+                        while(getline(inFile,line))
+                            if(line.rfind("//", 0) == string::npos)
+                                program.push_back(line);
+                        top1.add_thread(program);
                     }
                     inFile.close();
                     break;
+                case 'c':
+                    load_machine(argv[k+1]);
+                    break;
                 default:
                     show_message("Opção inválida",string("Opção \"") + string(argv[k]) + string("\" inválida"));
                     break;
@@ -899,12 +923,22 @@ int sc_main(int argc, char *argv[])
         }
     }
 
+    // Grava o estado montado pelas outras opcoes ('-g' e '-o')
+    if(image_out != "")
+        save_image(image_out);
+    if(project_out != "")
+        save_project(project_out);
+
     clock_control.enabled(false);
     run_all.enabled(false);
     
     start.events().click([&]
     {
-        if(fila)
+        //Regioes de memoria das threads e nucleos devem caber na memoria
+        vector<string> err = spec ? top::check_regions(config,mem_rows*50) : vector<string>();
+        if(err.size())
+            show_errors("Configuração inválida",err);
+        else if(fila)
         {
             start.enabled(false);
             clock_control.enabled(true);
@@ -913,18 +947,19 @@ int sc_main(int argc, char *argv[])
             op.enabled(0,false);
             op.enabled(1,false);
             op.enabled(3,false);
+            op.enabled(4,false);
             for(int i = 0; i < 2; i++)
                 spec_sub->enabled(i, false);
-            for(int i = 0 ; i < 8 ; i++)
+            for(int i = 0 ; i < 11 ; i++)
                 sub->enabled(i,false);
-            for(int i = 0 ; i < 10 ; i++)
+            for(unsigned int i = 0 ; i < benchmarks.size() ; i++)
                 bench_sub->enabled(i,false);
             if(spec){
                 // Flag mode setada pela escolha no menu
                 if(mode == 1)
-                    top1.rob_mode(n_bits,nadd,nmul,nls,instruct_time,instruction_queue,table,memory,reg,instruct,clock_count,rob);
+                    top1.rob_mode(n_bits,nadd,nmul,nls,instruct_time,config,instruction_queue,table,memory,reg,instruct,clock_count,rob);
                 else if(mode == 2)
-                    top1.rob_mode_bpb(n_bits, bpb_size, nadd,nmul,nls,instruct_time,instruction_queue,table,memory,reg,instruct,clock_count,rob);
+                    top1.rob_mode_bpb(n_bits, bpb_size, nadd,nmul,nls,instruct_time,config,instruction_queue,table,memory,reg,instruct,clock_count,rob);
             }
             else
                 top1.simple_mode(nadd,nmul,nls,instruct_time,instruction_queue,table,memory,reg,instruct,clock_count);
@@ -936,7 +971,7 @@ int sc_main(int argc, char *argv[])
 
     clock_control.events().click([&]
     {
-        if(spec && top1.get_rob_queue().queue_is_empty() && top1.get_rob().rob_is_empty())
+        if(spec && top1.rob_finished())
         {
             top1.metrics(cpu_freq, mode, bench_name, n_bits);
             return;
@@ -958,7 +993,7 @@ int sc_main(int argc, char *argv[])
                 should_break = true;
             }
         } else { // Speculative mode (mode == 1 or mode == 2)
-            if (top1.get_rob_queue().queue_is_empty() && top1.get_rob().rob_is_empty()){
+            if (top1.rob_finished()){
                 should_break = true;
             }
         }
@@ -1,14 +1,49 @@
 #include "general.hpp"
 #include "memory_rob.hpp"
 #include<vector>
+#include<algorithm>
 
 using std::vector;
 
 memory_rob::memory_rob(sc_module_name name, nana::grid &m): sc_module(name), mem(m)
 {
+    cache = NULL;
+    smt = NULL;
+    vlen = 4;
     SC_THREAD(leitura_bus);
     sensitive << in;
     dont_initialize();
+    SC_THREAD(escrita_cdb);
+    sensitive << pending_event;
+    dont_initialize();
+}
+
+void memory_rob::set_cache(data_cache *c)
+{
+    cache = c;
+}
+
+void memory_rob::set_smt(thread_select *s)
+{
+    smt = s;
+}
+
+void memory_rob::set_vlen(unsigned int n)
+{
+    vlen = n ? n : 4;
+}
+
+unsigned int memory_rob::owner(unsigned int rob_pos)
+{
+    return smt ? smt->entry_thread(rob_pos) : 0;
+}
+
+bool memory_rob::stale(unsigned int rob_pos, unsigned int gen)
+{
+    for(unsigned int k = gen ; k < flushes.size() ; k++)
+        if(flush_hits(flushes[k],rob_pos))
+            return true;
+    return false;
 }
 
 void memory_rob::leitura_bus()
@@ -19,6 +54,24 @@ void memory_rob::leitura_bus()
     while(true)
     {
         in->read(p);
+        //Flush do ROB: as respostas pendentes sao de loads descartados,
+        //mas os preenchimentos de linha ja iniciados continuam. Um pedido
+        //que ja aguardava o barramento chega depois do flush e tambem e
+        //descartado: o pedido leva os flushes que o buffer de loads tinha
+        //visto, e e velho se um flush posterior atingiu a sua entrada
+        if(is_flush(p))
+        {
+            for(auto it = pending.begin() ; it != pending.end() ; )
+            {
+                if(flush_hits(p,std::stoi(instruction_split(it->second)[0])))
+                    it = pending.erase(it);
+                else
+                    it++;
+            }
+            flushes.push_back(p);
+            wait();
+            continue;
+        }
         ord = instruction_split(p);
         pos = std::stoi(ord[1]);
 
@@ -30,13 +83,119 @@ void memory_rob::leitura_bus()
         }
         pos/=4;*/
 
-        if(ord[0] == "L")
+        if(ord[0] == "P") //prefetch do runahead, sem resposta
         {
-            escrita_saida = ord[2] + ' ' + mem.Get(pos);
-            out->write(escrita_saida);
+            if(cache)
+                cache->prefetch(pos,sc_time_stamp());
+        }
+        else if((ord[0].at(0) == 'L' || ord[0] == "PF") && stale(std::stoi(ord[2]),std::stoi(ord[3])))
+            cout << "Load do endereco " << pos << " descartado pelo flush" << endl << flush;
+        else if(ord[0] == "PF")
+        {
+            //PREF: inicia o preenchimento da linha e responde logo, sem dado,
+            //para a entrada do ROB poder sair no commit
+            if(cache)
+                cache->prefetch(pos,sc_time_stamp(),true);
+            pending.insert({sc_time_stamp(),ord[2] + " 0"});
+            pending_event.notify(SC_ZERO_TIME);
+        }
+        else if(ord[0].at(0) == 'L')
+        {
+            //LLD ("LL"): reserva o bloco para o SCD da mesma thread
+            if(ord[0] == "LL")
+                cache->link(owner(std::stoi(ord[2])),pos);
+            //Load especulado com endereco fora da memoria (caminho errado de um
+            //desvio ainda nao resolvido) le 0 em vez de interromper a simulacao
+            string value = "0";
+            unsigned int lat = 0;
+            if(ord[0] == "LV")
+            {
+                //LV: vlen palavras consecutivas, uma consulta a cache por bloco;
+                //o dado chega com o bloco mais lento
+                vector<int> lanes(vlen,0);
+                for(unsigned int e = 0 ; e < vlen ; e++)
+                {
+                    try
+                    {
+                        lanes[e] = std::stoi(mem.Get(pos+e));
+                    }
+                    catch(...)
+                    {
+                        cout << "Load no endereco " << pos+e << " fora da memoria, lido como 0" << endl << flush;
+                    }
+                    if(cache && (e == 0 || (pos+e) % cache->get_block() == 0))
+                        lat = std::max(lat,cache->access(pos+e,sc_time_stamp()));
+                }
+                value = lanes_join(lanes);
+            }
+            else
+            {
+                try
+                {
+                    value = mem.Get(pos);
+                }
+                catch(...)
+                {
+                    cout << "Load no endereco " << pos << " fora da memoria, lido como 0" << endl << flush;
+                }
+                lat = cache ? cache->access(pos,sc_time_stamp()) : 0;
+            }
+            escrita_saida = ord[2] + ' ' + value;
+            if(lat)
+            {
+                cout << "Miss na cache de dados no endereco " << pos << ": dado em " << lat << " ciclos" << endl << flush;
+                pending.insert({sc_time_stamp() + sc_time(lat,SC_NS),escrita_saida});
+                pending_event.notify(SC_ZERO_TIME);
+            }
+            //Com o CDB disputado a escrita pode esperar ciclos, e o proximo
+            //pedido do barramento de memoria seria perdido: a resposta vai para a fila
+            else
+            {
+                pending.insert({sc_time_stamp(),escrita_saida});
+                pending_event.notify(SC_ZERO_TIME);
+            }
+        }
+        else if(ord[0] == "B")
+        {
+            //Fence no commit: libera os loads mais novos retidos por ele
+            out_slb->write(ord[1]);
+        }
+        else if(ord[0] == "C")
+        {
+            //SCD: so escreve com a reserva do LLD valida, e responde no CDB
+            //com 1 (sucesso) ou 0. Os loads retidos pelo SCD sao liberados nos dois casos
+            bool ok = cache->check_link(owner(std::stoi(ord[3])),pos);
+            if(ok)
+                cache->write(pos,sc_time_stamp());
+            wait(SC_ZERO_TIME);
+            if(ok)
+                mem.Set(pos,std::to_string((int)std::stoi(ord[2])));
+            out_slb->write(ord[3]);
+            pending.insert({sc_time_stamp(),ord[3] + (ok ? " 1" : " 0")});
+            pending_event.notify(SC_ZERO_TIME);
+        }
+        else if(ord[0] == "SV")
+        {
+            //SV: os elementos vao para vlen palavras consecutivas e os loads
+            //retidos sao liberados uma vez, depois de todas as escritas
+            vector<int> lanes = lanes_split(ord[2],vlen);
+            if(cache)
+                for(unsigned int e = 0 ; e < vlen ; e++)
+                    if(e == 0 || (pos+e) % cache->get_block() == 0)
+                        cache->write(pos+e,sc_time_stamp());
+            wait(SC_ZERO_TIME);
+            for(unsigned int e = 0 ; e < vlen ; e++)
+                mem.Set(pos+e,std::to_string(lanes[e]));
+            out_slb->write(ord[3]);
         }
         else
         {
+            //Multicore: o store obtem a linha em M pelo barramento coerente.
+            //O nao temporal ("SN") escreve sem alocar a linha
+            if(cache && ord[0] == "SN")
+                cache->write_stream(pos,sc_time_stamp());
+            else if(cache)
+                cache->write(pos,sc_time_stamp());
             wait(SC_ZERO_TIME);
             mem.Set(pos,std::to_string((int)std::stoi(ord[2])));
             out_slb->write(ord[3]);
@@ -44,3 +203,22 @@ void memory_rob::leitura_bus()
         wait();
     }
 }
+
+//Entrega no CDB os valores dos loads com miss, em ordem de chegada da linha
+void memory_rob::escrita_cdb()
+{
+    string msg;
+    while(true)
+    {
+        if(pending.empty())
+            wait(pending_event);
+        else if(pending.begin()->first > sc_time_stamp())
+            wait(pending.begin()->first - sc_time_stamp(),pending_event);
+        else
+        {
+            msg = pending.begin()->second;
+            pending.erase(pending.begin());
+            out->write(msg);
+        }
+    }
+}
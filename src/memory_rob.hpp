@@ -1,5 +1,12 @@
 #include "interfaces.hpp"
 #include "grid.hpp"
+#include "data_cache.hpp"
+#include "thread_select.hpp"
+#include<map>
+#include<vector>
+
+using std::multimap;
+using std::vector;
 
 class memory_rob: public sc_module
 {
@@ -11,8 +18,27 @@ public:
     
     memory_rob(sc_module_name name, nana::grid &m);
     void leitura_bus();
+    void escrita_cdb();
+    // Da latencia aos loads pela cache de dados (nullptr = sem latencia)
+    void set_cache(data_cache *c);
+    // SMT: as reservas do LLD ficam por thread
+    void set_smt(thread_select *s);
+    // Elementos lidos pelo LV e escritos pelo SV
+    void set_vlen(unsigned int n);
     
 private:
     string p;
     nana::grid &mem;
+    data_cache *cache;
+    thread_select *smt;
+    unsigned int vlen;
+    multimap<sc_time,string> pending; //respostas de loads com miss, pelo instante de entrega
+    sc_event pending_event;
+    vector<string> flushes; //flushes recebidos, na ordem; podem ser so das entradas de uma thread
+
+    // Thread dona da entrada rob_pos do ROB
+    unsigned int owner(unsigned int rob_pos);
+    // Pedido de load da entrada rob_pos feito depois de gen flushes foi
+    // descartado por um flush seguinte
+    bool stale(unsigned int rob_pos, unsigned int gen);
 };
@@ -0,0 +1,210 @@
+#include "program_image.hpp"
+#include<fstream>
+#include<cstring>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+
+program_image::program_image()
+{
+    base = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+program_image::~program_image()
+{
+    close();
+}
+
+bool program_image::open(string path)
+{
+    close();
+    int fd = ::open(path.c_str(),O_RDONLY);
+    if(fd < 0)
+        return fail("nao foi possivel abrir " + path);
+    struct stat st;
+    if(fstat(fd,&st) < 0 || st.st_size < (off_t)sizeof(image_header))
+    {
+        ::close(fd);
+        return fail("arquivo menor que o cabecalho da imagem");
+    }
+    void *p = mmap(nullptr,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    //O mapeamento continua valido depois de fechar o descritor
+    ::close(fd);
+    if(p == MAP_FAILED)
+        return fail("falha no mmap de " + path);
+    base = (const char *)p;
+    size = st.st_size;
+    header = (const image_header *)base;
+    if(memcmp(header->magic,"TFSIMIMG",8))
+        return fail("arquivo nao e uma imagem do TFSim");
+    if(header->version != VERSION)
+        return fail("versao " + std::to_string(header->version) + " da imagem nao suportada");
+    //Secoes numericas e depois os textos, conferindo cada tamanho com o arquivo
+    uint64_t words = (uint64_t)header->int_count + header->fp_count + header->memory_count
+                     + header->config_count + header->latency_count;
+    uint64_t text_start = sizeof(image_header) + 4*words;
+    uint64_t end = text_start + header->program_bytes + header->config_bytes + header->latency_bytes;
+    if(end > size)
+        return fail("imagem truncada");
+    const int32_t *w = (const int32_t *)(base + sizeof(image_header));
+    config_values = w + header->int_count + header->fp_count + header->memory_count;
+    latency_values = config_values + header->config_count;
+    program_text = base + text_start;
+    config_keys = program_text + header->program_bytes;
+    latency_keys = config_keys + header->config_bytes;
+    //Cada bloco de texto precisa de um '\0' por string dentro do seu tamanho
+    const char *blocks[3] = {program_text,config_keys,latency_keys};
+    uint32_t bytes[3] = {header->program_bytes,header->config_bytes,header->latency_bytes};
+    uint32_t counts[3] = {header->program_count,header->config_count,header->latency_count};
+    for(unsigned int b = 0 ; b < 3 ; b++)
+    {
+        uint32_t zeros = 0;
+        for(uint32_t i = 0 ; i < bytes[b] ; i++)
+            if(!blocks[b][i])
+                zeros++;
+        if(zeros != counts[b] || (bytes[b] && blocks[b][bytes[b]-1]))
+            return fail("bloco de texto da imagem corrompido");
+    }
+    return true;
+}
+
+void program_image::close()
+{
+    if(base)
+        munmap((void *)base,size);
+    base = nullptr;
+    size = 0;
+    header = nullptr;
+}
+
+bool program_image::fail(string msg)
+{
+    error = msg;
+    close();
+    return false;
+}
+
+string program_image::get_error()
+{
+    return error;
+}
+
+vector<string> program_image::get_program()
+{
+    return split(program_text,header->program_count);
+}
+
+unsigned int program_image::get_int_count()
+{
+    return header->int_count;
+}
+
+const int32_t *program_image::get_int_regs()
+{
+    return (const int32_t *)(base + sizeof(image_header));
+}
+
+unsigned int program_image::get_fp_count()
+{
+    return header->fp_count;
+}
+
+const float *program_image::get_fp_regs()
+{
+    return (const float *)(get_int_regs() + header->int_count);
+}
+
+unsigned int program_image::get_memory_size()
+{
+    return header->memory_count;
+}
+
+const int32_t *program_image::get_memory()
+{
+    return get_int_regs() + header->int_count + header->fp_count;
+}
+
+unsigned int program_image::get_stations(unsigned int k)
+{
+    return header->stations[k];
+}
+
+map<string,int> program_image::get_config()
+{
+    return table(config_keys,config_values,header->config_count);
+}
+
+map<string,int> program_image::get_latencies()
+{
+    return table(latency_keys,latency_values,header->latency_count);
+}
+
+vector<string> program_image::split(const char *text, unsigned int count)
+{
+    vector<string> res;
+    res.reserve(count);
+    for(unsigned int i = 0 ; i < count ; i++)
+    {
+        res.push_back(text);
+        text += res.back().size() + 1;
+    }
+    return res;
+}
+
+map<string,int> program_image::table(const char *keys, const int32_t *values, unsigned int count)
+{
+    map<string,int> res;
+    vector<string> names = split(keys,count);
+    for(unsigned int i = 0 ; i < count ; i++)
+        res[names[i]] = values[i];
+    return res;
+}
+
+bool program_image::write(string path, const vector<string> &program, const vector<int32_t> &int_regs,
+                          const vector<float> &fp_regs, const vector<int32_t> &memory,
+                          const unsigned int stations[3], const map<string,int> &config,
+                          const map<string,int> &latencies)
+{
+    std::ofstream out(path,std::ios::binary);
+    if(!out.is_open())
+        return false;
+    image_header h;
+    memcpy(h.magic,"TFSIMIMG",8);
+    h.version = VERSION;
+    for(unsigned int k = 0 ; k < 3 ; k++)
+        h.stations[k] = stations[k];
+    string program_text,config_keys,latency_keys;
+    vector<int32_t> config_values,latency_values;
+    for(unsigned int i = 0 ; i < program.size() ; i++)
+        program_text += program[i] + '\0';
+    for(auto &c : config)
+    {
+        config_keys += c.first + '\0';
+        config_values.push_back(c.second);
+    }
+    for(auto &l : latencies)
+    {
+        latency_keys += l.first + '\0';
+        latency_values.push_back(l.second);
+    }
+    h.program_count = program.size();
+    h.program_bytes = program_text.size();
+    h.int_count = int_regs.size();
+    h.fp_count = fp_regs.size();
+    h.memory_count = memory.size();
+    h.config_count = config.size();
+    h.config_bytes = config_keys.size();
+    h.latency_count = latencies.size();
+    h.latency_bytes = latency_keys.size();
+    out.write((const char *)&h,sizeof(h));
+    out.write((const char *)int_regs.data(),4*int_regs.size());
+    out.write((const char *)fp_regs.data(),4*fp_regs.size());
+    out.write((const char *)memory.data(),4*memory.size());
+    out.write((const char *)config_values.data(),4*config_values.size());
+    out.write((const char *)latency_values.data(),4*latency_values.size());
+    out << program_text << config_keys << latency_keys;
+    return out.good();
+}
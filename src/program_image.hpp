@@ -0,0 +1,74 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<map>
+#include<cstdint>
+
+using std::vector;
+using std::string;
+using std::map;
+
+// Imagem binaria com o estado inicial de uma simulacao: programa, registradores
+// inteiros e PF, memoria e configuracao da maquina (estacoes de '-r', latencias
+// de '-l' e parametros de '-c'). O arquivo e mapeado com mmap e os vetores sao
+// lidos direto do mapeamento, sem o ifstream >> valor dos arquivos de texto,
+// o que importa para memorias de milhoes de palavras.
+// Formato (inteiros de 32 bits na ordem de bytes da maquina que gravou):
+//   cabecalho image_header
+//   registradores inteiros (int32), registradores PF (float), memoria (int32),
+//   valores da configuracao (int32), valores das latencias (int32)
+//   instrucoes da fila, cada uma terminada por '\0'
+//   chaves da configuracao e das latencias, cada uma terminada por '\0'
+// Secoes vazias mantem o valor atual do simulador.
+class program_image
+{
+public:
+    static const uint32_t VERSION = 1;
+
+    program_image();
+    ~program_image();
+    // Mapeia e valida o arquivo; em caso de erro get_error explica o motivo
+    bool open(string path);
+    void close();
+    string get_error();
+
+    vector<string> get_program();
+    unsigned int get_int_count();
+    const int32_t *get_int_regs();
+    unsigned int get_fp_count();
+    const float *get_fp_regs();
+    unsigned int get_memory_size();
+    const int32_t *get_memory();
+    // Estacoes ADD, MUL e LOAD/STORE (k = 0..2); 0 se ausente
+    unsigned int get_stations(unsigned int k);
+    map<string,int> get_config();
+    map<string,int> get_latencies();
+
+    // Grava a imagem; retorna false se nao conseguiu escrever o arquivo
+    static bool write(string path, const vector<string> &program, const vector<int32_t> &int_regs,
+                      const vector<float> &fp_regs, const vector<int32_t> &memory,
+                      const unsigned int stations[3], const map<string,int> &config,
+                      const map<string,int> &latencies);
+
+private:
+    struct image_header
+    {
+        char magic[8]; //"TFSIMIMG"
+        uint32_t version;
+        uint32_t stations[3];
+        uint32_t program_count,program_bytes;
+        uint32_t int_count,fp_count,memory_count;
+        uint32_t config_count,config_bytes;
+        uint32_t latency_count,latency_bytes;
+    };
+    const char *base; //inicio do mapeamento, nullptr se fechado
+    size_t size;
+    const image_header *header;
+    const char *program_text,*config_keys,*latency_keys;
+    const int32_t *config_values,*latency_values;
+    string error;
+
+    bool fail(string msg);
+    static vector<string> split(const char *text, unsigned int count);
+    static map<string,int> table(const char *keys, const int32_t *values, unsigned int count);
+};
@@ -6,6 +6,10 @@ using std::vector;
 
 register_bank_rob::register_bank_rob(sc_module_name name,nana::listbox &regs):sc_module(name), registers(regs)
 {
+    read_ports = write_ports = 0;
+    reads = writes = 0;
+    read_conflicts = write_conflicts = 0;
+    port_stamp = SC_ZERO_TIME;
     SC_THREAD(le_bus);
     sensitive << in;
     dont_initialize();
@@ -16,62 +20,113 @@ void register_bank_rob::le_bus()
     vector<string> ord;
     unsigned int index;
     string p;
-    bool fp;
     auto cat = registers.at(0);
     while(true)
     {
+        //Leitura ou escrita de valor sem porta livre espera o proximo ciclo.
+        //O pedido fica no barramento ate ser atendido, bloqueando os demais
+        p = "";
+        in->nb_read(p);
+        if(p.size() > 2 && p[2] == 'V' && !use_port(p[0] == 'W'))
+        {
+            if(p[0] == 'W')
+                write_conflicts++;
+            else
+                read_conflicts++;
+            do
+                wait(1,SC_NS);
+            while(!use_port(p[0] == 'W'));
+        }
         in->read(p);
         if(p == "F")
         {
-            for(unsigned int i = 0 ; i < 32 ; i++)
+            //No SMT o banco tem 32 registradores de cada tipo por thread
+            for(unsigned int i = 0 ; i < cat.size() ; i++)
             {
                 cat.at(i).text(IQ,"0");
                 cat.at(i).text(FQ,"0");
+                cat.at(i).text(VQ,"0");
+            }
+        }
+        else if(is_flush(p))
+        {
+            //Flush de uma thread: so as renomeacoes para as entradas dela
+            for(unsigned int i = 0 ; i < cat.size() ; i++)
+            {
+                if(flush_hits(p,std::stoi(cat.at(i).text(IQ))))
+                    cat.at(i).text(IQ,"0");
+                if(flush_hits(p,std::stoi(cat.at(i).text(FQ))))
+                    cat.at(i).text(FQ,"0");
+                if(flush_hits(p,std::stoi(cat.at(i).text(VQ))))
+                    cat.at(i).text(VQ,"0");
             }
         }
         else
         {
             ord = instruction_split(p);
             index = std::stoi(ord[2].substr(1,ord[2].size()-1));
+            //Colunas do valor e do Qi conforme o tipo do registrador
+            unsigned int value_col = IVALUE, q_col = IQ;
             if(ord[2].at(0) == 'F')
-                fp = true;
-            else
-                fp = false;
+            {
+                value_col = FVALUE;
+                q_col = FQ;
+            }
+            else if(ord[2].at(0) == 'V')
+            {
+                value_col = VVALUE;
+                q_col = VQ;
+            }
             if(ord[0] == "R")
             {
                 if(ord[1] == "S")
-                {
-                    if(fp)
-                        out->nb_write(cat.at(index).text(FQ));
-                    else
-                        out->nb_write(cat.at(index).text(IQ));
-                }
+                    out->nb_write(cat.at(index).text(q_col));
                 else
-                {
-                    if(fp)
-                        out->nb_write(cat.at(index).text(FVALUE));
-                    else
-                        out->nb_write(cat.at(index).text(IVALUE));
-                }
+                    out->nb_write(cat.at(index).text(value_col));
             }
             else
             {
                 if(ord[1] == "S")
-                {
-                    if(fp)
-                        cat.at(index).text(FQ,ord[3]);
-                    else
-                        cat.at(index).text(IQ,ord[3]);
-                }
+                    cat.at(index).text(q_col,ord[3]);
+                else if(value_col == IVALUE)
+                    cat.at(index).text(IVALUE,std::to_string(std::stoi(ord[3])));
                 else
-                {
-                    if(fp)
-                        cat.at(index).text(FVALUE,ord[3]);
-                    else
-                        cat.at(index).text(IVALUE,std::to_string(std::stoi(ord[3])));
-                }
+                    cat.at(index).text(value_col,ord[3]);
             }
         }
         wait();
     }
 }
+
+void register_bank_rob::set_ports(unsigned int rd, unsigned int wr)
+{
+    read_ports = rd;
+    write_ports = wr;
+}
+
+bool register_bank_rob::use_port(bool write)
+{
+    unsigned int limit = write ? write_ports : read_ports;
+    if(!limit)
+        return true;
+    if(port_stamp != sc_time_stamp())
+    {
+        port_stamp = sc_time_stamp();
+        reads = writes = 0;
+    }
+    unsigned int &used = write ? writes : reads;
+    if(used >= limit)
+        return false;
+    used++;
+    return true;
+}
+
+unsigned int register_bank_rob::get_read_conflicts()
+{
+    return read_conflicts;
+}
+
+unsigned int register_bank_rob::get_write_conflicts()
+{
+    return write_conflicts;
+}
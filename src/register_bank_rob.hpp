@@ -12,14 +12,26 @@ public:
 
     register_bank_rob(sc_module_name name,nana::listbox &regs);
     void le_bus();
+    // Portas de leitura e escrita de valores por ciclo (0 = sem limite)
+    void set_ports(unsigned int rd, unsigned int wr);
+    unsigned int get_read_conflicts();
+    unsigned int get_write_conflicts();
 
 private:
     nana::listbox &registers;
+    unsigned int read_ports,write_ports;
+    unsigned int reads,writes; //portas usadas no ciclo port_stamp
+    unsigned int read_conflicts,write_conflicts;
+    sc_time port_stamp;
+
+    bool use_port(bool write);
     enum
     {
         IVALUE = 1,
         IQ = 2,
         FVALUE = 4,
-        FQ = 5
+        FQ = 5,
+        VVALUE = 7,
+        VQ = 8
     };
 };
@@ -1,5 +1,7 @@
 #include <nana/gui.hpp>
 #include "reorder_buffer.hpp"
+#include<cctype>
+#include<algorithm>
 
 reorder_buffer::reorder_buffer(sc_module_name name,unsigned int sz,unsigned int pred_size, unsigned int buffer_size, int flag_mode, nana::listbox &gui, nana::listbox::cat_proxy instr_gui): 
 sc_module(name),
@@ -10,7 +12,23 @@ branch_prediction_buffer(buffer_size, pred_size),
 gui_table(gui),
 instr_queue_gui(instr_gui)
 {
-    last_rob = 0;
+    last_rob.assign(1,0);
+    issue_flushed = stale_issue = oper_read = redirecting = false;
+    full_stalls = fused_commits = 0;
+    move_elim = 0;
+    elim_zero = elim_move = elim_missed = 0;
+    vp_correct = vp_replays = 0;
+    vp_hidden = 0;
+    ra = NULL;
+    ra_threshold = 0;
+    mem_flush = head_blocked = false;
+    smt = NULL;
+    issue_thread = redirect_thread = commit_thread = 0;
+    ll_count = sc_count = sc_fails = fences = 0;
+    fence_loads = fence_stall = 0;
+    vlen = 4;
+    vec_count = 0;
+    branch_flushes = cmov_count = 0;
     branch_instr = {{"BEQ",0},{"BNE",1},{"BGTZ",2},{"BLTZ",3},{"BGEZ",4},{"BLEZ",5}};
     ptrs = new rob_slot*[tam];
     for(unsigned int i = 0 ; i < tam ; i++)
@@ -36,6 +54,9 @@ instr_queue_gui(instr_gui)
     SC_THREAD(check_conflict);
     sensitive << in_slb;
     dont_initialize();
+    SC_THREAD(run_ahead);
+    sensitive << ra_event;
+    dont_initialize();
 }
 
 reorder_buffer::~reorder_buffer()
@@ -47,27 +68,78 @@ reorder_buffer::~reorder_buffer()
 
 void reorder_buffer::leitura_issue()
 {
-    string p;
-    string inst;
+    string p,fused_msg,fused_reg;
+    string inst,text;
     vector<string> ord;
-    int pos,regst;
-    float value;
-    bool check_value;
+    int pos,regst,elim_kind;
+    float value,elim_value;
+    bool check_value,elim;
     auto cat = gui_table.at(0);
     while(true)
     {
-        pos = busy_check();
+        //SMT: a instrucao no barramento define a particao do ROB
+        if(smt)
+        {
+            p = "";
+            in_issue->nb_read(p);
+            if(p != "" && isalpha(p[0]))
+                issue_thread = instr_thread(p);
+        }
+        pos = busy_check(issue_thread);
         if(ptrs[pos]->busy)
         {
             cout << "ROB esta totalmente ocupado" << endl << flush;
-            wait(free_rob_event);
+            full_stalls++;
+            issue_flushed = false;
+            wait(free_rob_event | issue_flush_event);
+            if(issue_flushed)
+                pos = busy_check(issue_thread);
         }
         in_issue->read(p); // example, "DADDI R1,R1,1 0 1", instruction + general_pc + original_pc
-        out_issue->write(std::to_string(pos+1));
+        issue_flushed = false;
+        oper_read = false;
+        //Instrucao buscada antes do flush, descartada ("0" avisa o issue)
+        if(stale_issue)
+        {
+            stale_issue = false;
+            out_issue->write("0");
+            wait_issue();
+            continue;
+        }
+        //Eliminacao no rename: o issue nao envia a instrucao as estacoes ("E")
+        elim_kind = p.find(';') == string::npos ? eliminate(instruction_split(p),elim_value) : 0;
+        elim = elim_kind > 0;
+        if(issue_flushed)
+        {
+            out_issue->write("0");
+            wait_issue();
+            continue;
+        }
+        //Contada so depois do flush: a instrucao descartada nao foi eliminada
+        if(elim_kind == ELIM_ZERO)
+            elim_zero++;
+        else if(elim_kind == ELIM_MOVE)
+            elim_move++;
+        else if(elim_kind < 0)
+            elim_missed++;
+        if(elim)
+            out_issue->write("E " + std::to_string(pos+1));
+        else
+            out_issue->write(std::to_string(pos+1));
+        //Macro-op: instrucao seguida do desvio fundido, separados por ';'
+        fused_msg = "";
+        if(p.find(';') != string::npos)
+        {
+            fused_msg = p.substr(p.find(';')+1);
+            p = p.substr(0,p.find(';'));
+        }
         ord = instruction_split(p);
         inst = p.substr(0,instruction_pos_finder(p));
+        if(fused_msg != "")
+            inst += " + " + fused_msg.substr(0,instruction_pos_finder(fused_msg));
         cout << "Inserindo instrucao " << p << " no ROB " << pos+1 <<"|" << sc_time_stamp() << endl << flush;
         ptrs[pos]->busy = true;
+        update_occupancy(issue_thread);
         cat.at(pos).text(R_BUSY,"True");
         cat.at(pos).text(DESTINATION,"");
         cat.at(pos).text(VALUE,"");
@@ -79,27 +151,64 @@ void reorder_buffer::leitura_issue()
 
         ptrs[pos]->instr_pos = std::stoi(ord[ord.size()- 2]);
         ptrs[pos]->pc = std::stoi(ord[ord.size() - 1]);
+        ptrs[pos]->fused = "";
+        ptrs[pos]->lanes = "";
+        ptrs[pos]->predicted = false;
+        fused_reg = "";
+        if(fused_msg != "")
+            fused_reg = issue_fused(ptrs[pos],ord[1],fused_msg);
         //cout << "PC: " << ptrs[pos]->pc << endl;
         //cout << "instr_pos: " << ptrs[pos]->instr_pos << endl;
-        if(ord[0].at(0) == 'S')
+        if(elim)
         {
-            if(ord[0].at(1) == 'D'){
+            //Entrada ja nasce com o resultado, pronta para o commit
+            cout << "Instrucao " << ord[0] << " eliminada no rename com valor " << elim_value << endl << flush;
+            ptrs[pos]->destination = ord[1];
+            cat.at(pos).text(DESTINATION,ord[1]);
+            ptrs[pos]->value = elim_value;
+            cat.at(pos).text(VALUE,std::to_string((int)elim_value));
+            ptrs[pos]->state = WRITE;
+            cat.at(pos).text(STATE,"Write Result");
+            instr_queue_gui.at(ptrs[pos]->instr_pos).text(EXEC,std::to_string(sc_time_stamp().value() / 1000));
+            instr_queue_gui.at(ptrs[pos]->instr_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000));
+            ask_status(false,ord[1],pos+1);
+            ptrs[pos]->ready = true;
+        }
+        else if(ord[0] == "SYNC")
+        {
+            //Fence: sem destino nem endereco, retem os loads mais novos ate o commit
+            fence_holds.erase(pos+1);
+            ptrs[pos]->ready = true;
+        }
+        else if(ord[0].at(0) == 'S')
+        {
+            if(ord[0].at(1) == 'D' || ord[0] == "SCD" || ord[0] == "SV"){
                 check_value = false;
                 regst = ask_status(true,ord[1]);
                 if(regst != 0)
                 {
-                    if(ptrs[regst-1]->ready == true)
+                    if(value_ready(ptrs[regst-1]))
                     {
-                        value = std::stof(cat.at(regst-1).text(VALUE));
+                        text = cat.at(regst-1).text(VALUE);
+                        value = std::stof(text);
                         check_value = true;
                     }
                 }
                 if(regst == 0 || check_value == true)
                 {
                     if(check_value == false)
-                        value = ask_value(true,ord[1]);
+                    {
+                        text = ask_text(ord[1]);
+                        value = std::stof(text);
+                    }
                     ptrs[pos]->value = value;
-                    if(ord[1].at(0) != 'F')
+                    //SV: o dado sao os elementos do registrador vetorial
+                    if(ord[1].at(0) == 'V')
+                    {
+                        ptrs[pos]->lanes = text;
+                        cat.at(pos).text(VALUE,text);
+                    }
+                    else if(ord[1].at(0) != 'F')
                         cat.at(pos).text(VALUE,std::to_string((int)value));
                     else
                         cat.at(pos).text(VALUE,std::to_string(value));
@@ -107,82 +216,41 @@ void reorder_buffer::leitura_issue()
                 }
                 else
                     ptrs[pos]->qj = regst;
+                //SCD: o registrador lido tambem recebe o resultado (1 ou 0)
+                if(ord[0] == "SCD")
+                {
+                    ptrs[pos]->sc_reg = ord[1];
+                    ask_status(false,ord[1],pos+1);
+                }
             }
             else {
                 ptrs[pos]->destination = ord[1];
                 cat.at(pos).text(DESTINATION,ord[1]);
                 if(ord[0].at(0) != 'L')
-                    wait(resv_read_oper_event);
+                    wait_oper_read();
+                if(issue_flushed)
+                {
+                    wait_issue();
+                    continue;
+                }
+                if(fused_reg != "")
+                    read_operand(ptrs[pos],fused_reg,true);
                 ask_status(false,ord[1],pos+1);
             }
         }
         else if(ord[0].at(0) == 'B')
         {
-            ptrs[pos]->destination = ord[1];
-            regst = ask_status(true,ord[1]);
-            check_value = false;
-            if(regst != 0)
-            {
-                if(ptrs[regst-1]->ready == true)
-                {
-                    value = std::stof(cat.at(regst-1).text(VALUE));
-                    check_value = true;
-                }
-            }
-            if(regst == 0 || check_value == true)
-            {
-                if(check_value == false)
-                    value = ask_value(true,ord[1]);
-                ptrs[pos]->vj = value;
-            }
-            else
-                ptrs[pos]->qj = regst;
+            //Alvo e predicao dependem apenas do PC: a fila e redirecionada antes
+            //da leitura dos operandos, que pode esperar por uma porta do banco
             if(branch_instr[ord[0]] < 2) //instrucao com 2 operandos (BEQ,BNE)
-            {
-                regst = ask_status(true,ord[2]);
-                check_value = false;
-                if(regst != 0)
-                {
-                    if(ptrs[regst-1]->ready == true)
-                    {
-                        value = std::stof(cat.at(regst-1).text(VALUE));
-                        check_value = true;
-                    }
-                }
-                if(regst == 0 || check_value == true)
-                {
-                    if(check_value == false)
-                        value = ask_value(true,ord[2]);
-                    ptrs[pos]->vk = value;
-                }
-                else
-                    ptrs[pos]->qk = regst;
                 ptrs[pos]->destination = ord[3];
-                cat.at(pos).text(DESTINATION,ord[3]);
-            }
             else
-            {
-                cat.at(pos).text(DESTINATION,ord[2]);
                 ptrs[pos]->destination = ord[2];
-            }
-            
-            // Novo modo -> Se escolhido no menu, 1 preditor entra no if
-            //se escolhido o bpb, vai pro else
-            if(flag_mode == 1){
-                ptrs[pos]->prediction = preditor.predict();
-            }
-            else{
-                ptrs[pos]->prediction = branch_prediction_buffer.bpb_predict(ptrs[pos]->pc);
-            }
-            
-            if(ptrs[pos]->prediction){
-                cout << "Prediction of instruction " << ptrs[pos]->instr_pos << " | " << ptrs[pos]->instruction << " taken" << endl;
-                out_iq->write("S " + std::to_string(ptrs[pos]->entry) +  ' ' + ptrs[pos]->destination);
-            }
-            else{
-                cout << "Prediction of instruction " << ptrs[pos]->instr_pos << " | " << ptrs[pos]->instruction << " not taken" << endl;
-                out_iq->write("S " + std::to_string(ptrs[pos]->entry));
-            }
+            cat.at(pos).text(DESTINATION,ptrs[pos]->destination);
+            send_prediction(ptrs[pos],ptrs[pos]->destination);
+            read_operand(ptrs[pos],ord[1],false);
+            if(branch_instr[ord[0]] < 2)
+                read_operand(ptrs[pos],ord[2],true);
                 
             if(ptrs[pos]->qj == 0 && ptrs[pos]->qk == 0)
                 ptrs[pos]->ready = true;
@@ -194,110 +262,162 @@ void reorder_buffer::leitura_issue()
             out_iq->write("J " + std::to_string(ptrs[pos]->entry) +  ' ' + ptrs[pos]->destination);
             ptrs[pos]->ready = true;
         }
+        else if(ord[0] == "PREF")
+        {
+            //Prefetch: sem destino nem dado, fica pronto quando a memoria
+            //recebe o endereco
+            ptrs[pos]->destination = "";
+            ptrs[pos]->qj = ptrs[pos]->qk = 0;
+        }
         else
         {
             ptrs[pos]->destination = ord[1];
             cat.at(pos).text(DESTINATION,ord[1]);
             if(ord[0].at(0) != 'L')
-                wait(resv_read_oper_event);
+                wait_oper_read();
+            //Instrucao descartada pelo flush enquanto aguardava a leitura dos operandos
+            if(issue_flushed)
+            {
+                wait_issue();
+                continue;
+            }
+            if(fused_reg != "")
+                read_operand(ptrs[pos],fused_reg,true);
+            //Valor previsto fica visivel antes da renomeacao do destino
+            if(ord[0].at(0) == 'L')
+                predict_load(ptrs[pos]);
             ask_status(false,ord[1],pos+1);
         }
-        if(rob_buff.empty())
+        if(issue_flushed)
+        {
+            wait_issue();
+            continue;
+        }
+        if(!thread_head(issue_thread))
             new_rob_head_event.notify(1,SC_NS);
         rob_buff.push_back(ptrs[pos]);
-        wait();
+        wait_issue();
     }
 }
 
 // Onde há o commit das instruções
 void reorder_buffer::new_rob_head() 
 {
-    unsigned int instr_type;
-    bool pred, hit;
     auto cat = gui_table.at(0);
+    bool flushed;
+    rob_slot *head;
     while(true)
     {
-        if(rob_buff.empty())
-            wait(new_rob_head_event);
-        if(!rob_buff[0]->ready)
-            wait(rob_head_value_event);
-        rob_buff[0]->state = COMMIT;
+        if(smt)
+            head = ready_head();
+        else
+        {
+            if(rob_buff.empty())
+                wait(new_rob_head_event);
+            if(!rob_buff[0]->ready)
+            {
+                head_blocked = true;
+                head_stamp = sc_time_stamp();
+                if(ra)
+                    ra_event.notify(ra_threshold,SC_NS);
+                wait(rob_head_value_event);
+                head_blocked = false;
+            }
+            head = rob_buff[0];
+        }
+        flushed = false;
+        head->state = COMMIT;
         wait(SC_ZERO_TIME);
-        cat.at(rob_buff[0]->entry-1).text(STATE,"Commit");
+        cat.at(head->entry-1).text(STATE,"Commit");
 
-        switch(rob_buff[0]->instruction.at(0)){
+        switch(head->instruction.at(0)){
             case 'S':
-                if(rob_buff[0]->instruction.at(1) == 'D'){
-                    mem_write(std::stoi(rob_buff[0]->destination),rob_buff[0]->value,rob_buff[0]->entry);
+                if(head->instruction == "SCD")
+                    commit_sc(head);
+                else if(head->instruction == "SYNC")
+                    commit_fence(head);
+                else if(head->instruction == "SV"){
+                    //Uma escrita com todos os elementos, em enderecos consecutivos
+                    out_mem->write("SV " + head->destination + ' ' + head->lanes + ' ' + std::to_string(head->entry));
+                    mem_count++;
+                }
+                else if(head->instruction.at(1) == 'D'){
+                    mem_write(std::stoi(head->destination),head->value,head->entry,head->instruction == "SDNT");
                     mem_count++;
                 }
                 else {
                     wait(SC_ZERO_TIME);
-                    unsigned int regst = ask_status(true,rob_buff[0]->destination);
-                    ask_value(false,rob_buff[0]->destination,rob_buff[0]->value);
-                    if(regst == rob_buff[0]->entry)
-                        ask_status(false,rob_buff[0]->destination,0);
+                    //Status lido depois da escrita do valor: a espera pela porta de escrita
+                    //nao pode esconder uma renomeacao mais nova do registrador
+                    ask_value(false,head->destination,head->value,head->lanes);
+                    unsigned int regst = ask_status(true,head->destination);
+                    if(regst == head->entry)
+                        ask_status(false,head->destination,0);
                 }
                 break;
             
             case 'B':
-                instr_queue_gui.at(rob_buff[0]->instr_pos).text(EXEC,std::to_string(sc_time_stamp().value() / 1000)); //text(EXEC,"X");
-                instr_queue_gui.at(rob_buff[0]->instr_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000)); //text(WRITE,"X");
-                instr_type = branch_instr[rob_buff[0]->instruction];
-                if(instr_type < 2)
-                    pred = branch(instr_type,rob_buff[0]->vj,rob_buff[0]->vk);
-                else
-                    pred = branch(instr_type,(float)rob_buff[0]->vj);
-
-                hit = (pred == rob_buff[0]->prediction);
-
-                if(!hit){
-                    if(pred)
-                        out_iq->write(rob_buff[0]->destination + ' ' + std::to_string(rob_buff[0]->entry));
-                    else
-                        out_iq->write("R " + std::to_string(rob_buff[0]->entry));
-                    cout << "-----------------LIMPANDO ROB no ciclo " << sc_time_stamp() << " -----------------" << endl << flush;
-                    _flush(); //Esvazia o ROB
-                    out_resv_adu->write("F");
-                    out_slb->write("F");
-                    out_rb->write("F");
-                    out_adu->write("F");
-                }
+                flushed = commit_branch(head,head->instruction,head->destination,head->instr_pos);
+                break;
 
-                cout << "Atualizando bpb" << endl << flush;
-                if(flag_mode == 1){
-                    preditor.update_state(pred, hit);
-                }else{
-                    branch_prediction_buffer.bpb_update_state(rob_buff[0]->pc, pred, hit);
-                }
+            case 'P':
+                //PREF: a linha ja foi pedida, nada a escrever
                 break;
 
             case 'J':
-                instr_queue_gui.at(rob_buff[0]->instr_pos).text(EXEC,std::to_string(sc_time_stamp().value() / 1000)); //text(EXEC,"X");
-                instr_queue_gui.at(rob_buff[0]->instr_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000)); //text(WRITE,"X");
+                instr_queue_gui.at(head->instr_pos).text(EXEC,std::to_string(sc_time_stamp().value() / 1000)); //text(EXEC,"X");
+                instr_queue_gui.at(head->instr_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000)); //text(WRITE,"X");
                 break;
                 
             default: // Write destination register
-                if(rob_buff[0]->instruction.at(0) == 'L')
+                if(head->instruction.at(0) == 'L')
                     mem_count++;
+                if(head->instruction == "LLD")
+                    ll_count++;
                 wait(SC_ZERO_TIME);
-                unsigned int regst = ask_status(true,rob_buff[0]->destination);
-                ask_value(false,rob_buff[0]->destination,rob_buff[0]->value);
-                if(regst == rob_buff[0]->entry)
-                    ask_status(false,rob_buff[0]->destination,0);
+                //Status lido depois da escrita do valor: a espera pela porta de escrita
+                //nao pode esconder uma renomeacao mais nova do registrador
+                ask_value(false,head->destination,head->value,head->lanes);
+                unsigned int regst = ask_status(true,head->destination);
+                if(regst == head->entry)
+                    ask_status(false,head->destination,0);
+        }
+
+        //Load com valor previsto: conferido depois da escrita do registrador
+        if(!flushed && head->instruction.at(0) == 'L')
+            flushed = commit_load(head);
+
+        //Macro-op: o desvio fundido e resolvido depois da escrita do registrador
+        if(!flushed && head->fused != "")
+        {
+            fused_commits++;
+            flushed = commit_branch(head,head->fused,head->target,head->fused_pos);
         }
 
         // Remove head instruction from buffer
-        if(!rob_buff.empty())
+        //Depois de um flush a fila pode ja ter uma instrucao nova, que nao e removida
+        if(!flushed)
         {
-            rob_buff[0]->busy = false;
-            cat.at(rob_buff[0]->entry-1).text(R_BUSY,"False");
-            rob_buff[0]->ready = false;
-            rob_buff[0]->destination = "";
-            rob_buff[0]->qj = rob_buff[0]->qk = 0;
-            cout << "Commit da instrucao " << rob_buff[0]->instruction << " com valor " << rob_buff[0]->value << " no ciclo " << sc_time_stamp() << endl << flush;
+            head->busy = false;
+            cat.at(head->entry-1).text(R_BUSY,"False");
+            head->ready = false;
+            head->destination = "";
+            head->qj = head->qk = 0;
+            if(is_vector_op(head->instruction))
+                vec_count++;
+            if(head->instruction == "MOVZ" || head->instruction == "MOVN")
+                cmov_count++;
+            if(head->fused != "")
+                head->instruction += "+" + head->fused;
+            head->fused = "";
+            cout << "Commit da instrucao " << head->instruction << " com valor " << head->value << " no ciclo " << sc_time_stamp() << endl << flush;
             free_rob_event.notify(1,SC_NS);
-            rob_buff.pop_front();
+            rob_buff.erase(std::find(rob_buff.begin(),rob_buff.end(),head));
+            if(smt)
+            {
+                smt->commit(entry_thread(head->entry));
+                update_occupancy(entry_thread(head->entry));
+            }
         }
         wait(1,SC_NS);
     }
@@ -316,18 +436,30 @@ void reorder_buffer::leitura_cdb()
         ord = instruction_split(p);
         index = std::stoi(ord[0]);
         value = std::stof(ord[1]);
-        check_dependencies(index,value);
+        check_dependencies(index,value,ord[1]);
         if(ptrs[index-1]->busy)
         {
-            ptrs[index-1]->ready = true;
+            //Macro-op ainda pode aguardar o outro operando do desvio
+            ptrs[index-1]->ready = ptrs[index-1]->qj == 0 && ptrs[index-1]->qk == 0;
+            //Ganho do primeiro dependente que leu o valor previsto; somado no
+            //commit se a previsao estiver correta
+            if(ptrs[index-1]->predicted && ptrs[index-1]->pred_used)
+                ptrs[index-1]->pred_gain = (sc_time_stamp() - ptrs[index-1]->pred_time).value() / 1000;
             ptrs[index-1]->value = value;
-            if(ptrs[index-1]->destination.at(0) != 'F')
+            //PREF nao tem destino
+            string dest = ptrs[index-1]->destination;
+            if(dest != "" && dest.at(0) == 'V')
+            {
+                ptrs[index-1]->lanes = ord[1];
+                cat.at(index-1).text(VALUE,ord[1]);
+            }
+            else if(dest == "" || dest.at(0) != 'F')
                 cat.at(index-1).text(VALUE,std::to_string((int)value));
             else
                 cat.at(index-1).text(VALUE,std::to_string(value));
             ptrs[index-1]->state = WRITE;
             cat.at(index-1).text(STATE,"Write Result");
-            if(rob_buff[0]->entry == index)
+            if(is_head(index) && ptrs[index-1]->ready)
                 rob_head_value_event.notify(1,SC_NS);
         }
         wait();
@@ -354,7 +486,7 @@ void reorder_buffer::leitura_adu()
             cat.at(index-1).text(STATE,"Write Result");
             instr_queue_gui.at(ptrs[index-1]->instr_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000)); //text(WRITE,"X");
         }
-        if(rob_buff[0]->entry == index && ptrs[index-1]->ready)
+        if(is_head(index) && ptrs[index-1]->ready)
             rob_head_value_event.notify(1,SC_NS); 
         wait();
     }
@@ -368,24 +500,447 @@ void reorder_buffer::check_conflict()
     {
         last_st = 0;
         in_slb->nb_read(p);
-        if(p != "F")
+        if(!is_flush(p))
         {
             in_slb->notify();
             ord = instruction_split(p);
             rob_pos = std::stoi(ord[0]);
-            for(unsigned int i = 0 ; i < rob_pos-1 ; i++)
-                if( ptrs[i]->instruction.at(0) == 'S' && ptrs[i]->busy && ptrs[i]->destination == ord[1])
-                    last_st = i+1;
+            unsigned int width = ptrs[rob_pos-1]->instruction == "LV" ? vlen : 1;
+            //Percorre o ROB em ordem de programa (da cabeca ate o load)
+            //Store com endereco ainda desconhecido tambem conta como conflito.
+            //No SMT so os stores da mesma thread sao considerados
+            //O fence (SYNC) nunca tem endereco e retem todos os loads mais novos;
+            //o SCD que ja foi a memoria no commit (alem de ISSUE) nao retem mais.
+            //LV e SV acessam vlen palavras: conflito se as faixas se sobrepoem.
+            for(unsigned int i = 0 ; i < rob_buff.size() && rob_buff[i]->entry != rob_pos ; i++)
+                if( rob_buff[i]->instruction.at(0) == 'S' && rob_buff[i]->busy && (rob_buff[i]->destination == ord[1] || rob_buff[i]->destination == "" || mem_overlap(rob_buff[i],std::stoul(ord[1]),width)) && entry_thread(rob_buff[i]->entry) == entry_thread(rob_pos) && !(rob_buff[i]->instruction == "SCD" && rob_buff[i]->state != ISSUE))
+                    last_st = rob_buff[i]->entry;
+            if(last_st && ptrs[last_st-1]->instruction == "SYNC")
+                fence_holds[last_st].push_back(sc_time_stamp());
             out_slb->write(std::to_string(last_st));
         }
         wait();
     }
 }
 
-int reorder_buffer::busy_check()
+//Le o operando reg de um desvio: valor do banco ou do ROB, ou a tag que o produz
+void reorder_buffer::read_operand(rob_slot *slot, string reg, bool second)
+{
+    auto cat = gui_table.at(0);
+    float value = 0;
+    bool check_value = false;
+    unsigned int regst = ask_status(true,reg);
+    if(regst != 0 && value_ready(ptrs[regst-1]))
+    {
+        value = std::stof(cat.at(regst-1).text(VALUE));
+        check_value = true;
+    }
+    if(regst == 0 || check_value == true)
+    {
+        if(check_value == false)
+            value = ask_value(true,reg);
+        if(second)
+        {
+            slot->vk = value;
+            slot->qk = 0;
+        }
+        else
+        {
+            slot->vj = value;
+            slot->qj = 0;
+        }
+    }
+    else if(second)
+        slot->qk = regst;
+    else
+        slot->qj = regst;
+}
+
+//Prediz o desvio e informa a fila de instrucoes do salto especulado
+void reorder_buffer::send_prediction(rob_slot *slot, string target)
+{
+    //O barramento da fila aceita uma escrita por ciclo: uma predicao que
+    //chegasse depois do redirecionamento sobrescreveria o caminho correto
+    if((redirecting && redirect_thread == entry_thread(slot->entry)) || issue_flushed)
+        return;
+    // Novo modo -> Se escolhido no menu, 1 preditor entra no if
+    //se escolhido o bpb, vai pro else
+    if(flag_mode == 1){
+        slot->prediction = preditor.predict();
+    }
+    else{
+        slot->prediction = branch_prediction_buffer.bpb_predict(slot->pc);
+    }
+    
+    string op = slot->fused != "" ? slot->fused : slot->instruction;
+    unsigned int instr_pos = slot->fused != "" ? slot->fused_pos : slot->instr_pos;
+    //Com a FTQ vale a direcao prevista quando o bloco foi formado, que e o
+    //caminho que a busca ja seguiu
+    if(fetch_prediction)
+    {
+        int early = fetch_prediction(entry_thread(slot->entry),instr_pos);
+        if(early >= 0)
+            slot->prediction = early;
+    }
+    if(slot->prediction){
+        cout << "Prediction of instruction " << instr_pos << " | " << op << " taken" << endl;
+        out_iq->write("S " + std::to_string(slot->entry) +  ' ' + target);
+    }
+    else{
+        cout << "Prediction of instruction " << instr_pos << " | " << op << " not taken" << endl;
+        out_iq->write("S " + std::to_string(slot->entry));
+    }
+}
+
+//Espera as estacoes lerem os operandos da instrucao ("N"), ou um flush.
+//O aviso fica registrado se chegar antes da espera
+void reorder_buffer::wait_oper_read()
+{
+    while(!oper_read && !issue_flushed)
+        wait(resv_read_oper_event | issue_flush_event);
+    oper_read = false;
+}
+
+//Macro-op: o desvio br compara o resultado da propria entrada (reg rd, em qj)
+//com o outro operando, cujo nome e retornado para ser lido depois que as
+//estacoes leem os operandos. O PC do preditor passa a ser o do desvio
+string reorder_buffer::issue_fused(rob_slot *slot, string rd, string br)
+{
+    vector<string> ord = instruction_split(br);
+    slot->fused = ord[0];
+    slot->fused_pos = std::stoi(ord[ord.size()-2]);
+    slot->pc = std::stoi(ord[ord.size()-1]);
+    slot->qj = slot->entry;
+    if(branch_instr[ord[0]] < 2)
+        slot->target = ord[3];
+    else
+        slot->target = ord[2];
+    send_prediction(slot,slot->target);
+    if(branch_instr[ord[0]] < 2)
+    {
+        //Tag inexistente: o CDB nao pode liberar o commit antes da leitura do operando
+        slot->qk = tam+1;
+        return ord[1] == rd ? ord[2] : ord[1];
+    }
+    return "";
+}
+
+//Envia msg para a fila de instrucoes e esvazia o ROB e as demais unidades.
+//No SMT so as entradas da thread da entrada entry sao descartadas ("F lo hi")
+void reorder_buffer::redirect(string msg, unsigned int entry)
+{
+    unsigned int t = entry_thread(entry);
+    string flush_msg = "F";
+    if(smt)
+        flush_msg = "F " + std::to_string(smt->first_entry(t)) + ' ' + std::to_string(smt->last_entry(t));
+    redirecting = true;
+    redirect_thread = t;
+    if(mem_flush)
+        out_mem->write(flush_msg);
+    out_iq->write(msg);
+    cout << "-----------------LIMPANDO ROB no ciclo " << sc_time_stamp() << " -----------------" << endl << flush;
+    _flush(t); //Esvazia o ROB
+    redirecting = false;
+    out_resv_adu->write(flush_msg);
+    out_slb->write(flush_msg);
+    out_rb->write(flush_msg);
+    out_adu->write(flush_msg);
+}
+
+//Resolve o desvio op da entrada slot no commit; em caso de erro de predicao
+//redireciona a fila e esvazia o ROB (retorna true)
+bool reorder_buffer::commit_branch(rob_slot *slot, string op, string target, unsigned int gui_pos)
+{
+    bool pred,hit;
+    unsigned int instr_type;
+    instr_queue_gui.at(gui_pos).text(EXEC,std::to_string(sc_time_stamp().value() / 1000)); //text(EXEC,"X");
+    instr_queue_gui.at(gui_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000)); //text(WRITE,"X");
+    instr_type = branch_instr[op];
+    if(instr_type < 2)
+        pred = branch(instr_type,slot->vj,slot->vk);
+    else
+        pred = branch(instr_type,(float)slot->vj);
+
+    hit = (pred == slot->prediction);
+
+    if(!hit){
+        branch_flushes++;
+        if(pred)
+            redirect(target + ' ' + std::to_string(slot->entry),slot->entry);
+        else
+            redirect("R " + std::to_string(slot->entry),slot->entry);
+    }
+
+    cout << "Atualizando bpb" << endl << flush;
+    if(flag_mode == 1){
+        preditor.update_state(pred, hit);
+    }else{
+        branch_prediction_buffer.bpb_update_state(slot->pc, pred, hit);
+    }
+    return !hit;
+}
+
+unsigned int reorder_buffer::get_branch_flushes()
+{
+    return branch_flushes;
+}
+
+unsigned int reorder_buffer::get_cmov_count()
+{
+    return cmov_count;
+}
+
+unsigned int reorder_buffer::get_waiting(unsigned int tag)
+{
+    unsigned int n = 0;
+    for(unsigned int i = 0 ; i < tam ; i++)
+        if(ptrs[i]->busy && (ptrs[i]->qj == tag || ptrs[i]->qk == tag))
+            n++;
+    return n;
+}
+
+unsigned int reorder_buffer::get_full_stalls()
 {
-    unsigned int ret = last_rob;
-    last_rob = (last_rob+1)%tam;
+    return full_stalls;
+}
+
+unsigned int reorder_buffer::get_fused_commits()
+{
+    return fused_commits;
+}
+
+void reorder_buffer::set_move_elim(int mode)
+{
+    move_elim = mode;
+}
+
+unsigned int reorder_buffer::get_elim_zero()
+{
+    return elim_zero;
+}
+
+unsigned int reorder_buffer::get_elim_move()
+{
+    return elim_move;
+}
+
+unsigned int reorder_buffer::get_elim_missed()
+{
+    return elim_missed;
+}
+
+void reorder_buffer::set_value_pred(int mode, unsigned int size, unsigned int threshold)
+{
+    vpred = value_predictor(size,mode,threshold);
+}
+
+value_predictor &reorder_buffer::get_value_pred()
+{
+    return vpred;
+}
+
+unsigned int reorder_buffer::get_vp_correct()
+{
+    return vp_correct;
+}
+
+unsigned int reorder_buffer::get_vp_replays()
+{
+    return vp_replays;
+}
+
+unsigned int reorder_buffer::get_vp_hidden()
+{
+    return vp_hidden;
+}
+
+unsigned int reorder_buffer::get_ll_count()
+{
+    return ll_count;
+}
+
+unsigned int reorder_buffer::get_sc_count()
+{
+    return sc_count;
+}
+
+unsigned int reorder_buffer::get_sc_fails()
+{
+    return sc_fails;
+}
+
+unsigned int reorder_buffer::get_fences()
+{
+    return fences;
+}
+
+unsigned int reorder_buffer::get_fence_loads()
+{
+    return fence_loads;
+}
+
+unsigned int reorder_buffer::get_fence_stall()
+{
+    return fence_stall;
+}
+
+void reorder_buffer::set_runahead(runahead *r, unsigned int threshold)
+{
+    ra = r;
+    ra_threshold = threshold;
+}
+
+void reorder_buffer::set_fetch_prediction(std::function<int(unsigned int,unsigned int)> f)
+{
+    fetch_prediction = f;
+}
+
+void reorder_buffer::set_mem_flush(bool f)
+{
+    mem_flush = f;
+}
+
+//Load bloqueando a cabeca ha ra_threshold ciclos: as instrucoes seguintes sao
+//pre-executadas so para gerar prefetches, ate o valor do load chegar.
+//Nada e commitado nesse intervalo, entao o ROB nao precisa ser esvaziado
+void reorder_buffer::run_ahead()
+{
+    rob_slot *slot;
+    int addr;
+    while(true)
+    {
+        sc_time limit = head_stamp + sc_time(ra_threshold,SC_NS);
+        if(head_blocked && sc_time_stamp() < limit)
+            wait(limit - sc_time_stamp(),ra_event);
+        else if(head_blocked && rob_buff[0]->instruction.at(0) == 'L' && !rob_buff[0]->ready)
+        {
+            slot = rob_buff[0];
+            cout << "Load no ROB " << slot->entry << " bloqueando o commit: runahead iniciado no ciclo " << sc_time_stamp() << endl << flush;
+            ra->start(slot->pc,slot->destination);
+            while(head_blocked && rob_buff[0] == slot)
+            {
+                addr = ra->step(sc_time_stamp());
+                if(addr >= 0)
+                {
+                    cout << "Prefetch do endereco " << addr << " pelo runahead" << endl << flush;
+                    out_mem->write("P " + std::to_string(addr));
+                }
+                wait(1,SC_NS);
+            }
+            ra->stop();
+            cout << "Fim do runahead no ciclo " << sc_time_stamp() << endl << flush;
+        }
+        else
+            wait(ra_event);
+    }
+}
+
+//Previsao do valor do load: os dependentes leem o valor previsto do ROB.
+//A fila guarda o ponto de retorno ("V") para refazer a partir da instrucao seguinte
+void reorder_buffer::predict_load(rob_slot *slot)
+{
+    unsigned int n = 0;
+    float value;
+    //A mensagem chegaria a fila depois de um redirecionamento. O preditor
+    //guarda valores escalares: LV nao e previsto
+    if(slot->instruction == "LV")
+        return;
+    if((redirecting && redirect_thread == entry_thread(slot->entry)) || issue_flushed)
+        return;
+    for(unsigned int i = 0 ; i < rob_buff.size() ; i++)
+        if(rob_buff[i]->pc == slot->pc && rob_buff[i]->instruction.at(0) == 'L' && entry_thread(rob_buff[i]->entry) == entry_thread(slot->entry))
+            n++;
+    if(!vpred.predict(slot->pc,n,value))
+        return;
+    slot->predicted = true;
+    slot->pred_value = value;
+    slot->pred_used = false;
+    slot->pred_gain = 0;
+    if(slot->destination.at(0) != 'F')
+        gui_table.at(0).at(slot->entry-1).text(VALUE,std::to_string((int)value));
+    else
+        gui_table.at(0).at(slot->entry-1).text(VALUE,std::to_string(value));
+    cout << "Valor do load no ROB " << slot->entry << " previsto: " << value << endl << flush;
+    out_iq->write("V " + std::to_string(slot->entry) + ' ' + std::to_string(slot->instr_pos));
+}
+
+//Treina o preditor de valor e confere a previsao; em caso de erro as
+//instrucoes seguintes ao load sao refeitas (retorna true)
+bool reorder_buffer::commit_load(rob_slot *slot)
+{
+    vpred.update(slot->pc,slot->value);
+    if(!slot->predicted)
+        return false;
+    slot->predicted = false;
+    if(slot->value == slot->pred_value)
+    {
+        vp_correct++;
+        vp_hidden += slot->pred_gain;
+        return false;
+    }
+    vp_replays++;
+    cout << "Valor previsto " << slot->pred_value << " do load no ROB " << slot->entry << " incorreto (real " << slot->value << ")" << endl << flush;
+    redirect("R " + std::to_string(slot->entry),slot->entry);
+    return true;
+}
+
+//Zeramentos (DADD Rx,R0,R0; DADDI Rx,R0,0; DSUB Rx,Ry,Ry) e copias
+//(DADD Rx,Ry,R0; DADDI Rx,Ry,0; DSUB Rx,Ry,R0) resolvidos no rename.
+//R0 e tratado como zero, como no MIPS. A copia so e eliminada se o valor
+//da origem ja estiver no banco de registradores ou em uma entrada pronta
+int reorder_buffer::eliminate(vector<string> ord, float &value)
+{
+    if(!move_elim || ord.size() < 4 || ord[1].at(0) != 'R')
+        return 0;
+    bool add = ord[0] == "DADD" || ord[0] == "DADDU";
+    bool addi = ord[0] == "DADDI" || ord[0] == "DADDIU";
+    bool sub = ord[0] == "DSUB" || ord[0] == "DSUBU";
+    if(!add && !addi && !sub)
+        return 0;
+    bool imm_zero = addi && std::stoi(ord[3]) == 0;
+    string src = "";
+    if((add && ord[2] == "R0" && ord[3] == "R0") || (addi && ord[2] == "R0" && imm_zero) || (sub && ord[2] == ord[3]))
+    {
+        if(!(move_elim & ELIM_ZERO))
+            return 0;
+        value = 0;
+        return ELIM_ZERO;
+    }
+    if((add || sub) && ord[3] == "R0")
+        src = ord[2];
+    else if(add && ord[2] == "R0")
+        src = ord[3];
+    else if(imm_zero)
+        src = ord[2];
+    if(src == "" || !(move_elim & ELIM_MOVE))
+        return 0;
+    unsigned int regst = ask_status(true,src);
+    if(regst == 0)
+        value = ask_value(true,src);
+    else if(value_ready(ptrs[regst-1]))
+        value = std::stof(gui_table.at(0).at(regst-1).text(VALUE));
+    else
+        return -1;
+    return ELIM_MOVE;
+}
+
+//Espera a proxima instrucao do issue, que pode ter chegado enquanto o ROB
+//aguardava o banco de registradores
+void reorder_buffer::wait_issue()
+{
+    string p = "";
+    in_issue->nb_read(p);
+    if(p == "" || !isalpha(p[0]))
+        wait();
+}
+//Proxima entrada da particao da thread t (o ROB inteiro sem SMT)
+int reorder_buffer::busy_check(unsigned int t)
+{
+    unsigned int ret = last_rob[t];
+    if(smt)
+        last_rob[t] = smt->first_entry(t)-1 + (last_rob[t]+1-(smt->first_entry(t)-1))%smt->get_partition();
+    else
+        last_rob[t] = (last_rob[t]+1)%tam;
     return ret;
 }
 unsigned int reorder_buffer::ask_status(bool read,string reg,unsigned int pos)
@@ -401,47 +956,92 @@ unsigned int reorder_buffer::ask_status(bool read,string reg,unsigned int pos)
         out_rb->write("W S " + reg + " " + std::to_string(pos));
     return 0;
 }
-float reorder_buffer::ask_value(bool read,string reg,float value)
+float reorder_buffer::ask_value(bool read,string reg,float value,string lanes)
 {
-    string res;
     if(read)
-    {
-        out_rb->write("R V " + reg);
-        in_rb->read(res);
-        return std::stof(res);
-    }
+        return std::stof(ask_text(reg));
+    else if(lanes != "")
+        out_rb->write("W V " + reg + ' ' + lanes);
     else
         out_rb->write("W V " + reg + ' ' + std::to_string(value));
     return 0;
 }
-void reorder_buffer::mem_write(unsigned int addr,float value,unsigned int rob_pos)
+string reorder_buffer::ask_text(string reg)
+{
+    string res;
+    out_rb->write("R V " + reg);
+    in_rb->read(res);
+    return res;
+}
+//Store (SD, SCD ou SV) da entrada slot escreve alguma das width palavras a
+//partir de addr
+bool reorder_buffer::mem_overlap(rob_slot *slot, unsigned int addr, unsigned int width)
+{
+    if(slot->destination == "" || (slot->instruction != "SV" && width == 1))
+        return false;
+    if(slot->instruction != "SD" && slot->instruction != "SDNT" && slot->instruction != "SCD" && slot->instruction != "SV")
+        return false;
+    unsigned int st = std::stoul(slot->destination);
+    unsigned int st_width = slot->instruction == "SV" ? vlen : 1;
+    return st < addr + width && addr < st + st_width;
+}
+void reorder_buffer::mem_write(unsigned int addr,float value,unsigned int rob_pos,bool stream)
+{
+    out_mem->write((stream ? "SN " : "S ") + std::to_string(addr) + ' ' + std::to_string(value) + ' ' + std::to_string(rob_pos));
+}
+//Resultado do registrador de destino disponivel na entrada. O SCD fica pronto
+//para o commit com endereco e dado, mas o resultado so existe depois da
+//resposta da memoria, que passa a entrada para WRITE
+bool reorder_buffer::value_ready(rob_slot *slot)
+{
+    return slot->ready && (slot->instruction != "SCD" || slot->state == WRITE);
+}
+
+//SCD no commit: a memoria confere a reserva do LLD, escreve se ela continua
+//valida e responde no CDB, e o resultado vai para o registrador
+void reorder_buffer::commit_sc(rob_slot *slot)
+{
+    out_mem->write("C " + slot->destination + ' ' + std::to_string(slot->value) + ' ' + std::to_string(slot->entry));
+    mem_count++;
+    slot->ready = false;
+    while(!slot->ready)
+        wait(rob_head_value_event);
+    sc_count++;
+    if(slot->value == 0)
+    {
+        sc_fails++;
+        cout << "SCD da entrada " << slot->entry << " falhou: reserva do LLD perdida" << endl << flush;
+    }
+    wait(SC_ZERO_TIME);
+    ask_value(false,slot->sc_reg,slot->value);
+    unsigned int regst = ask_status(true,slot->sc_reg);
+    if(regst == slot->entry)
+        ask_status(false,slot->sc_reg,0);
+}
+
+//Fence no commit: os stores anteriores ja foram escritos e os loads retidos
+//pelo SYNC sao liberados pela memoria, como depois de um store
+void reorder_buffer::commit_fence(rob_slot *slot)
 {
-    out_mem->write("S " + std::to_string(addr) + ' ' + std::to_string(value) + ' ' + std::to_string(rob_pos));
+    fences++;
+    for(sc_time t : fence_holds[slot->entry])
+    {
+        fence_loads++;
+        fence_stall += (sc_time_stamp() - t).value() / 1000;
+    }
+    fence_holds.erase(slot->entry);
+    out_mem->write("B " + std::to_string(slot->entry));
+    instr_queue_gui.at(slot->instr_pos).text(EXEC,std::to_string(sc_time_stamp().value() / 1000));
+    instr_queue_gui.at(slot->instr_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000));
 }
-void reorder_buffer::check_dependencies(unsigned int index, float value)
+
+void reorder_buffer::check_dependencies(unsigned int index, float value, string text)
 {
     auto cat = gui_table.at(0);
     for(unsigned int i = 0 ; i < tam ; i++)
     {
-        if(ptrs[i]->busy && ptrs[i]->instruction.at(0) == 'S')
-        {
-            if(ptrs[i]->instruction.at(1) == 'D'){
-                if(ptrs[i]->qj == index){
-                    ptrs[i]->value = value;
-                    cat.at(i).text(VALUE,std::to_string((int)value));
-                    ptrs[i]->qj = 0;
-                    if(ptrs[i]->destination != "")
-                    {
-                        cat.at(i).text(STATE,"Write Result");
-                        instr_queue_gui.at(ptrs[i]->instr_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000)); //text(WRITE,"X");
-                        ptrs[i]->ready = true;
-                    }
-                    if(rob_buff[0]->entry == index && ptrs[i]->ready)
-                        rob_head_value_event.notify(1,SC_NS);
-                }
-            }
-        }
-        else if(ptrs[i]->busy && ptrs[i]->instruction.at(0) == 'B')
+        //Desvios e macro-ops (a entrada fundida aguarda o proprio resultado em qj)
+        if(ptrs[i]->busy && (ptrs[i]->instruction.at(0) == 'B' || ptrs[i]->fused != ""))
         {
             if(ptrs[i]->qj == index)
             {
@@ -455,9 +1055,33 @@ void reorder_buffer::check_dependencies(unsigned int index, float value)
             }
             if(ptrs[i]->qj == 0 && ptrs[i]->qk == 0)
                 ptrs[i]->ready = true;
-            if(rob_buff[0]->entry == index && ptrs[i]->ready)
+            if(is_head(index) && ptrs[i]->ready)
                 rob_head_value_event.notify(1,SC_NS);
         }
+        else if(ptrs[i]->busy && ptrs[i]->instruction.at(0) == 'S')
+        {
+            if(ptrs[i]->instruction.at(1) == 'D' || ptrs[i]->instruction == "SCD" || ptrs[i]->instruction == "SV"){
+                if(ptrs[i]->qj == index){
+                    ptrs[i]->value = value;
+                    if(ptrs[i]->instruction == "SV")
+                    {
+                        ptrs[i]->lanes = text;
+                        cat.at(i).text(VALUE,text);
+                    }
+                    else
+                        cat.at(i).text(VALUE,std::to_string((int)value));
+                    ptrs[i]->qj = 0;
+                    if(ptrs[i]->destination != "")
+                    {
+                        cat.at(i).text(STATE,"Write Result");
+                        instr_queue_gui.at(ptrs[i]->instr_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000)); //text(WRITE,"X");
+                        ptrs[i]->ready = true;
+                    }
+                    if(is_head(index) && ptrs[i]->ready)
+                        rob_head_value_event.notify(1,SC_NS);
+                }
+            }
+        }
     }
 }
 void reorder_buffer::value_check()
@@ -466,37 +1090,78 @@ void reorder_buffer::value_check()
     auto cat = gui_table.at(0);
     while(true)
     {
-        in_resv_adu->read(p);
+        //O barramento tambem leva o "F" do flush as estacoes: so consome pedidos
+        p = "";
+        in_resv_adu->nb_read(p);
+        if(p == "" || p == " " || is_flush(p))
+        {
+            wait();
+            continue;
+        }
+        in_resv_adu->notify();
         if(p == "N")
+        {
+            oper_read = true;
             resv_read_oper_event.notify();
+        }
         if(p != "N")
         {
             int index = std::stoi(p);
-            if(ptrs[index-1]->ready)
+            //Load com valor previsto entrega o valor especulativo
+            if(value_ready(ptrs[index-1]) || ptrs[index-1]->predicted)
+            {
+                if(!value_ready(ptrs[index-1]) && !ptrs[index-1]->pred_used)
+                {
+                    ptrs[index-1]->pred_used = true;
+                    ptrs[index-1]->pred_time = sc_time_stamp();
+                }
                 out_resv_adu->write(cat.at(index-1).text(VALUE));
+            }
             else
                 out_resv_adu->write("EMPTY");
         }
         wait();
     }
 }
-void reorder_buffer::_flush()
+void reorder_buffer::_flush(unsigned int t)
 {
     auto cat = gui_table.at(0);
-    rob_buff.clear();
-    last_rob = 0;
+    //No SMT as entradas das outras threads continuam no ROB
+    for(unsigned int i = 0 ; i < rob_buff.size() ; )
+    {
+        if(entry_thread(rob_buff[i]->entry) == t)
+            rob_buff.erase(rob_buff.begin() + i);
+        else
+            i++;
+    }
+    last_rob[t] = smt ? smt->first_entry(t)-1 : 0;
+    if(issue_thread == t)
+    {
+        issue_flushed = true;
+        issue_flush_event.notify();
+    }
+    //Uma instrucao pendente no barramento do issue pertence ao caminho descartado
+    string pend = "";
+    in_issue->nb_read(pend);
+    if(pend != "" && isalpha(pend[0]) && instr_thread(pend) == t)
+        stale_issue = true;
     for(unsigned int i = 0 ; i < tam ; i++)
     {
+        if(entry_thread(i+1) != t)
+            continue;
         ptrs[i]->busy = false;
         ptrs[i]->ready = false;
         ptrs[i]->destination = "";
         ptrs[i]->qj = ptrs[i]->qk = 0;
+        ptrs[i]->fused = "";
+        ptrs[i]->predicted = false;
         cat.at(i).text(R_BUSY,"False");
         cat.at(i).text(INSTRUCTION,"");
         cat.at(i).text(STATE,"");
         cat.at(i).text(DESTINATION,"");
         cat.at(i).text(VALUE,"");
     }
+    update_occupancy(t);
 }
 bool reorder_buffer::branch(int optype,int rs,int rt)
 {
@@ -574,6 +1239,95 @@ bpb reorder_buffer::get_bpb() {
     return branch_prediction_buffer;
 }
 
+bool reorder_buffer::peek_prediction(unsigned int pc)
+{
+    if(flag_mode == 1)
+        return preditor.peek();
+    return branch_prediction_buffer.bpb_peek(pc);
+}
+
 int reorder_buffer::get_mem_count(){
     return mem_count;
 }
+
+void reorder_buffer::set_smt(thread_select *s)
+{
+    smt = s;
+    last_rob.resize(smt->get_threads());
+    for(unsigned int t = 0 ; t < smt->get_threads() ; t++)
+        last_rob[t] = smt->first_entry(t)-1;
+}
+
+void reorder_buffer::set_vlen(unsigned int n)
+{
+    vlen = n ? n : 4;
+}
+
+unsigned int reorder_buffer::get_vec_count()
+{
+    return vec_count;
+}
+
+unsigned int reorder_buffer::entry_thread(unsigned int entry)
+{
+    return smt ? smt->entry_thread(entry) : 0;
+}
+
+//Thread da instrucao p ("DADDI R1,R1,1 gpc pc", com o desvio fundido depois de ';')
+unsigned int reorder_buffer::instr_thread(string p)
+{
+    if(!smt)
+        return 0;
+    vector<string> ord = instruction_split(p.substr(0,p.find(';')));
+    return smt->instr_thread(std::stoi(ord[ord.size()-2]));
+}
+
+//Entrada mais antiga da thread t no ROB (NULL se a thread nao tem entradas)
+reorder_buffer::rob_slot *reorder_buffer::thread_head(unsigned int t)
+{
+    for(unsigned int i = 0 ; i < rob_buff.size() ; i++)
+        if(entry_thread(rob_buff[i]->entry) == t)
+            return rob_buff[i];
+    return NULL;
+}
+
+//A entrada index e a cabeca da sua thread?
+bool reorder_buffer::is_head(unsigned int index)
+{
+    if(!smt)
+        return rob_buff[0]->entry == index;
+    rob_slot *head = thread_head(entry_thread(index));
+    return head && head->entry == index;
+}
+
+//SMT: cada thread commita em ordem, mas uma cabeca bloqueada nao segura as
+//outras threads. O commit atende em rodizio as threads com a cabeca pronta
+reorder_buffer::rob_slot *reorder_buffer::ready_head()
+{
+    while(true)
+    {
+        for(unsigned int k = 1 ; k <= smt->get_threads() ; k++)
+        {
+            unsigned int t = (commit_thread + k) % smt->get_threads();
+            rob_slot *head = thread_head(t);
+            if(head && head->ready)
+            {
+                commit_thread = t;
+                return head;
+            }
+        }
+        wait(1,SC_NS);
+    }
+}
+
+//Informa ao arbitro da busca quantas entradas da particao da thread t estao ocupadas
+void reorder_buffer::update_occupancy(unsigned int t)
+{
+    if(!smt)
+        return;
+    unsigned int n = 0;
+    for(unsigned int e = smt->first_entry(t) ; e <= smt->last_entry(t) ; e++)
+        if(ptrs[e-1]->busy)
+            n++;
+    smt->set_occupancy(t,n);
+}
@@ -2,10 +2,14 @@
 #include "interfaces.hpp"
 #include "branch_predictor.hpp"
 #include "bpb.hpp"
+#include "value_predictor.hpp"
+#include "runahead.hpp"
+#include "thread_select.hpp"
 #include <nana/gui/widgets/listbox.hpp>
 #include<vector>
 #include<deque>
 #include<map>
+#include<functional>
 
 using std::vector;
 using std::deque;
@@ -36,11 +40,52 @@ public:
     void leitura_adu();
     void value_check();
     void check_conflict();
+    void run_ahead();
 
     bool rob_is_empty();
     branch_predictor get_preditor();
     bpb get_bpb();
+    // Predicao atual do desvio no PC original pc, sem atualizar o preditor
+    bool peek_prediction(unsigned int pc);
+    // Front end desacoplado: f(thread, posicao na fila) da a direcao que a
+    // FTQ previu para o desvio (-1 = sem predicao da FTQ, usa o preditor)
+    void set_fetch_prediction(std::function<int(unsigned int,unsigned int)> f);
     int get_mem_count();
+    // Entradas (desvios, macro-ops e stores) que aguardam o resultado do ROB tag
+    unsigned int get_waiting(unsigned int tag);
+    unsigned int get_full_stalls();
+    unsigned int get_fused_commits();
+    // Desvios mal previstos no commit, cada um esvazia o ROB
+    unsigned int get_branch_flushes();
+    unsigned int get_cmov_count();
+    // Eliminacao no rename (soma dos bits): 1 = zeramentos, 2 = copias de registrador
+    enum { ELIM_ZERO = 1, ELIM_MOVE = 2 };
+    void set_move_elim(int mode);
+    unsigned int get_elim_zero();
+    unsigned int get_elim_move();
+    unsigned int get_elim_missed();
+    // Previsao de valor de loads (modos de value_predictor)
+    void set_value_pred(int mode, unsigned int size, unsigned int threshold);
+    value_predictor &get_value_pred();
+    unsigned int get_vp_correct();
+    unsigned int get_vp_replays();
+    unsigned int get_vp_hidden();
+    // Sincronizacao: LLD/SCD commitados, SCD que falharam e fences (SYNC)
+    unsigned int get_ll_count();
+    unsigned int get_sc_count();
+    unsigned int get_sc_fails();
+    unsigned int get_fences();
+    unsigned int get_fence_loads();
+    unsigned int get_fence_stall();
+    // Runahead quando um load bloqueia a cabeca por threshold ciclos (nullptr = desligado)
+    void set_runahead(runahead *r, unsigned int threshold);
+    // Memoria com latencia: o flush tambem descarta as respostas de loads pendentes
+    void set_mem_flush(bool f);
+    // SMT: ROB dividido em particoes por thread, com commit e flush independentes
+    void set_smt(thread_select *s);
+    // Elementos por registrador vetorial (LV/SV acessam vlen palavras)
+    void set_vlen(unsigned int n);
+    unsigned int get_vec_count();
 
 private:
     struct rob_slot{
@@ -56,9 +101,20 @@ private:
         unsigned int qj,qk;
         unsigned int instr_pos; // general pc (instruction position gui)
         unsigned int pc; //original pc of instruction
+        string fused; //desvio fundido a instrucao (macro-op), vazio se nao houver
+        string target; //alvo do desvio fundido
+        unsigned int fused_pos; //posicao do desvio fundido na fila (gui)
+        bool predicted; //load com valor previsto ainda nao conferido
+        float pred_value;
+        bool pred_used; //algum dependente leu o valor previsto antes do real
+        sc_time pred_time; //primeira leitura do valor previsto
+        unsigned int pred_gain; //ciclos entre essa leitura e o valor real
+        string sc_reg; //registrador que recebe o resultado do SCD
+        string lanes; //elementos do resultado vetorial ou do dado do SV
         rob_slot(unsigned int id)
         {
-            busy = ready = false;
+            busy = ready = predicted = pred_used = false;
+            pred_gain = 0;
             entry = id;
             qj = qk = 0;
         }
@@ -71,10 +127,14 @@ private:
         COMMIT = 4
     };
     unsigned int tam;
-    unsigned int last_rob;
+    vector<unsigned int> last_rob; //ultima entrada alocada, por thread
     rob_slot **ptrs;
     deque<rob_slot *> rob_buff;
-    sc_event free_rob_event,new_rob_head_event,rob_head_value_event,resv_read_oper_event;
+    sc_event free_rob_event,new_rob_head_event,rob_head_value_event,resv_read_oper_event,issue_flush_event;
+    bool issue_flushed; //flush ocorreu durante o issue da instrucao atual
+    bool stale_issue; //instrucao pendente no barramento do issue no momento do flush
+    bool oper_read; //estacoes ja leram os operandos da instrucao atual ("N")
+    bool redirecting; //commit esta redirecionando a fila por erro de predicao
     // flag to mode
     // 1-> 1 preditor; 2-> bpb
     int flag_mode;
@@ -84,14 +144,63 @@ private:
     nana::listbox &gui_table;
     nana::listbox::cat_proxy instr_queue_gui;
     int mem_count = 0;
+    unsigned int full_stalls; //issue bloqueado com o ROB cheio
+    unsigned int fused_commits; //macro-ops commitados, cada um poupa uma entrada
+    int move_elim;
+    unsigned int elim_zero,elim_move; //instrucoes resolvidas no rename, sem estacao
+    unsigned int elim_missed; //copias executadas por a origem ainda estar pendente
+    value_predictor vpred;
+    unsigned int vp_correct,vp_replays;
+    unsigned int vp_hidden; //ciclos ganhos pelos dependentes nas previsoes corretas commitadas
+    runahead *ra;
+    unsigned int ra_threshold;
+    bool mem_flush;
+    std::function<int(unsigned int,unsigned int)> fetch_prediction;
+    bool head_blocked; //commit aguardando o valor da cabeca desde head_stamp
+    sc_time head_stamp;
+    sc_event ra_event;
+    thread_select *smt;
+    unsigned int issue_thread; //thread da instrucao em issue
+    unsigned int redirect_thread; //thread sendo redirecionada pelo commit
+    unsigned int commit_thread; //ultima thread que commitou
+    unsigned int ll_count,sc_count,sc_fails,fences;
+    unsigned int fence_loads,fence_stall; //loads retidos por um fence e os ciclos de espera
+    map<unsigned int,vector<sc_time>> fence_holds; //instantes em que cada fence reteve um load
+    unsigned int vlen;
+    unsigned int vec_count; //instrucoes vetoriais commitadas
+    unsigned int branch_flushes,cmov_count;
 
-    int busy_check();
+    int busy_check(unsigned int t);
     unsigned int ask_status(bool read,string reg,unsigned int pos = 0);
-    float ask_value(bool read,string reg,float value = 0);
-    void mem_write(unsigned int addr,float value,unsigned int rob_pos);
-    void check_dependencies(unsigned int index, float value);
-    void _flush();
+    float ask_value(bool read,string reg,float value = 0,string lanes = "");
+    string ask_text(string reg);
+    bool mem_overlap(rob_slot *slot, unsigned int addr, unsigned int width);
+    // Store no commit; stream: nao temporal (SDNT), sem alocar linha na cache
+    void mem_write(unsigned int addr,float value,unsigned int rob_pos,bool stream = false);
+    void check_dependencies(unsigned int index, float value, string text);
+    void _flush(unsigned int t);
+    void wait_issue();
+    void read_operand(rob_slot *slot, string reg, bool second);
+    void send_prediction(rob_slot *slot, string target);
+    void wait_oper_read();
+    string issue_fused(rob_slot *slot, string rd, string br);
+    // ELIM_ZERO ou ELIM_MOVE se a instrucao pode ser eliminada, 0 se nao e
+    // -1 se e uma copia com a origem ainda pendente
+    int eliminate(vector<string> ord, float &value);
+    void predict_load(rob_slot *slot);
+    bool commit_load(rob_slot *slot);
+    bool value_ready(rob_slot *slot);
+    void commit_sc(rob_slot *slot);
+    void commit_fence(rob_slot *slot);
+    void redirect(string msg, unsigned int entry);
+    bool commit_branch(rob_slot *slot, string op, string target, unsigned int gui_pos);
     bool branch(int optype,int rs = 0,int rt = 0);
     bool branch(int optype,float value);
     int instruction_pos_finder(string p);
+    unsigned int entry_thread(unsigned int entry);
+    unsigned int instr_thread(string p);
+    rob_slot *thread_head(unsigned int t);
+    bool is_head(unsigned int index);
+    rob_slot *ready_head();
+    void update_occupancy(unsigned int t);
 };
@@ -0,0 +1,718 @@
+#include "res_pool_rob.hpp"
+#include "general.hpp"
+#include<cstdlib>
+#include<algorithm>
+
+res_pool_rob::res_pool_rob(unsigned int n, map<string,int> inst_map, int pol, unsigned int crit_size):
+qj(n,0),
+qk(n,0),
+vj(n,0),
+vk(n,0),
+ql(n,0),
+vl(n,0),
+lj(n),
+lk(n),
+dest(n,0),
+a(n,0),
+instr_pos(n,0),
+fp(n,0),
+op(n),
+pc(n,0),
+fu(n,-1),
+avail(n,SC_ZERO_TIME),
+instruct_time(inst_map),
+tam(n),
+policy(pol),
+class_of(n,-1),
+rnd(n,0),
+holds_fu(n,0),
+crit(crit_size)
+{
+    words = (tam+63)/64;
+    busy_mask.assign(words,0);
+    ready_mask.assign(words,0);
+    issue_mask.assign(words,0);
+    older.assign(tam,vector<uint64_t>(words,0));
+    select_count = contention_count = changed_count = oldest_changed = 0;
+    flush_gen = 0;
+    window = busy_count = full_stalls = 0;
+    occ_area = 0;
+    occ_stamp = SC_ZERO_TIME;
+    bypass_latency = bypass_miss = bypass_hits = bypass_misses = 0;
+    bypass_partial = false;
+    clusters = 1;
+    cluster_delay = 0;
+    steer = STEER_ROUND_ROBIN;
+    cluster_of.assign(tam,-1);
+    cluster_local = cluster_cross = steer_follow = 0;
+    vlen = vwidth = 4;
+}
+
+unsigned int res_pool_rob::size()
+{
+    return tam;
+}
+
+unsigned int res_pool_rob::add_class(unsigned int first, unsigned int last)
+{
+    vector<uint64_t> mask(words,0);
+    for(unsigned int i = first ; i < last && i < tam ; i++)
+    {
+        mask[i/64] |= (uint64_t)1 << (i%64);
+        class_of[i] = class_mask.size();
+    }
+    class_mask.push_back(mask);
+    class_limit.push_back(0);
+    class_busy.push_back(0);
+    class_peak.push_back(0);
+    class_area.push_back(0);
+    return class_mask.size()-1;
+}
+
+int res_pool_rob::find_free(unsigned int cls, const vector<string> &src)
+{
+    if(window && busy_count >= window)
+        return -1;
+    if(class_limit[cls] && class_busy[cls] >= class_limit[cls])
+        return -1;
+    if(clusters > 1)
+    {
+        int c = steer_cluster(cls,src);
+        if(c >= 0)
+        {
+            vector<uint64_t> sel(words);
+            for(unsigned int w = 0 ; w < words ; w++)
+                sel[w] = class_mask[cls][w] & cluster_mask[c][w];
+            return first_set(busy_mask,sel,true);
+        }
+    }
+    return first_set(busy_mask,class_mask[cls],true);
+}
+
+void res_pool_rob::set_window(unsigned int n)
+{
+    window = n;
+}
+
+bool res_pool_rob::is_unified()
+{
+    return window != 0;
+}
+
+void res_pool_rob::set_class_limit(unsigned int cls, unsigned int n)
+{
+    class_limit[cls] = n;
+}
+
+int res_pool_rob::find_ready(unsigned int cls)
+{
+    return first_set(ready_mask,class_mask[cls],false);
+}
+
+bool res_pool_rob::is_busy(unsigned int i)
+{
+    return (busy_mask[i/64] >> (i%64)) & 1;
+}
+
+void res_pool_rob::set_busy(unsigned int i, bool b)
+{
+    uint64_t bit = (uint64_t)1 << (i%64);
+    if(b != is_busy(i))
+    {
+        double dt = (sc_time_stamp() - occ_stamp).value();
+        occ_area += busy_count * dt;
+        for(unsigned int c = 0 ; c < class_busy.size() ; c++)
+            class_area[c] += class_busy[c] * dt;
+        occ_stamp = sc_time_stamp();
+        busy_count += b ? 1 : -1;
+        if(class_of[i] >= 0)
+        {
+            unsigned int &cb = class_busy[class_of[i]];
+            cb += b ? 1 : -1;
+            if(cb > class_peak[class_of[i]])
+                class_peak[class_of[i]] = cb;
+        }
+        if(!b)
+            free_event.notify(SC_ZERO_TIME);
+    }
+    if(b)
+    {
+        // Toda estacao ja ocupada e mais antiga que a nova
+        older[i] = busy_mask;
+        tag_pc[dest[i]] = pc[i];
+        tag_class[dest[i]] = class_of[i];
+        if(clusters > 1)
+        {
+            tag_cluster[dest[i]] = cluster_of[i];
+            if(cluster_of[i] >= 0)
+                cluster_issued[cluster_of[i]]++;
+        }
+        busy_mask[i/64] |= bit;
+        issue_mask[i/64] &= ~bit;
+    }
+    else
+    {
+        busy_mask[i/64] &= ~bit;
+        ready_mask[i/64] &= ~bit;
+        for(unsigned int j = 0 ; j < tam ; j++)
+            older[j][i/64] &= ~bit;
+    }
+}
+
+void res_pool_rob::set_issuing(unsigned int i, bool b)
+{
+    uint64_t bit = (uint64_t)1 << (i%64);
+    if(b)
+        issue_mask[i/64] |= bit;
+    else
+        issue_mask[i/64] &= ~bit;
+}
+
+bool res_pool_rob::is_ready(unsigned int i)
+{
+    return (ready_mask[i/64] >> (i%64)) & 1;
+}
+
+void res_pool_rob::set_ready(unsigned int i, bool b)
+{
+    uint64_t bit = (uint64_t)1 << (i%64);
+    if(b)
+    {
+        if(!(ready_mask[i/64] & bit))
+            rnd[i] = rand();
+        ready_mask[i/64] |= bit;
+    }
+    else
+        ready_mask[i/64] &= ~bit;
+}
+
+void res_pool_rob::wakeup(int tag, float value, vector<unsigned int> &woken_j, vector<unsigned int> &woken_k, vector<unsigned int> &woken_l)
+{
+    // Percorre so as estacoes ocupadas e as em issue, que ja definiram
+    // qj/qk/ql mas ainda leem os operandos antes de set_busy
+    for(unsigned int w = 0 ; w < words ; w++)
+    {
+        uint64_t m = busy_mask[w] | issue_mask[w];
+        while(m)
+        {
+            unsigned int i = w*64 + __builtin_ctzll(m);
+            m &= m-1;
+            if(!qj[i] && !qk[i] && !ql[i])
+                continue;
+            bool waited = qj[i] == tag || qk[i] == tag || ql[i] == tag;
+            if(qj[i] == tag)
+            {
+                qj[i] = 0;
+                vj[i] = value;
+                woken_j.push_back(i);
+                avail[i] = std::max(avail[i],sc_time_stamp() + sc_time(bypass_delay(tag,i),SC_NS));
+            }
+            if(qk[i] == tag)
+            {
+                qk[i] = 0;
+                vk[i] = value;
+                woken_k.push_back(i);
+                avail[i] = std::max(avail[i],sc_time_stamp() + sc_time(bypass_delay(tag,i),SC_NS));
+            }
+            if(ql[i] == tag)
+            {
+                ql[i] = 0;
+                vl[i] = value;
+                woken_l.push_back(i);
+                avail[i] = std::max(avail[i],sc_time_stamp() + sc_time(bypass_delay(tag,i),SC_NS));
+            }
+            // O produtor e critico para i se entregou o ultimo operando que faltava
+            if(waited && tag_pc.count(tag))
+                crit.update_state(tag_pc[tag],!qj[i] && !qk[i] && !ql[i]);
+            if(!qj[i] && !qk[i] && !ql[i])
+                set_ready(i,true);
+        }
+    }
+}
+
+unsigned int res_pool_rob::add_fu(unsigned int n)
+{
+    fu_count.push_back(n);
+    fu_busy.push_back(0);
+    return fu_count.size()-1;
+}
+
+bool res_pool_rob::grant(unsigned int i)
+{
+    if(fu[i] < 0 || fu_count[fu[i]] == 0)
+    {
+        set_ready(i,false);
+        return true;
+    }
+    unsigned int c = fu[i];
+    if(fu_busy[c] >= fu_count[c])
+        return false;
+    vector<uint64_t> cand(words,0);
+    unsigned int n_cand = 0;
+    for(unsigned int w = 0 ; w < words ; w++)
+    {
+        uint64_t m = ready_mask[w];
+        while(m)
+        {
+            unsigned int j = w*64 + __builtin_ctzll(m);
+            m &= m-1;
+            if(fu[j] == (int)c && avail[j] <= sc_time_stamp())
+            {
+                cand[w] |= (uint64_t)1 << (j%64);
+                n_cand++;
+            }
+        }
+    }
+    int pick = select(cand);
+    if(pick != (int)i)
+    {
+        // A escolhida ainda vai pedir a unidade; reavalia no proximo ciclo
+        fu_event.notify(1,SC_NS);
+        return false;
+    }
+    select_count++;
+    if(n_cand > 1)
+    {
+        contention_count++;
+        if(pick != first_set(cand,cand,false))
+            changed_count++;
+        // Compara com a selecao pela mais antiga no mesmo cenario
+        if(!is_oldest(pick,cand))
+            oldest_changed++;
+    }
+    fu_busy[c]++;
+    holds_fu[i] = 1;
+    set_ready(i,false);
+    fu_event.notify(SC_ZERO_TIME);
+    return true;
+}
+
+void res_pool_rob::release(unsigned int i)
+{
+    if(!holds_fu[i])
+        return;
+    holds_fu[i] = 0;
+    fu_busy[fu[i]]--;
+    fu_event.notify(SC_ZERO_TIME);
+}
+
+int res_pool_rob::get_policy()
+{
+    return policy;
+}
+
+void res_pool_rob::set_rob_waiting(std::function<unsigned int(unsigned int)> f)
+{
+    rob_waiting = f;
+}
+
+string res_pool_rob::policy_name(int policy)
+{
+    switch(policy)
+    {
+        case SEL_OLDEST:
+            return "Mais antiga (matriz de idade)";
+        case SEL_RANDOM:
+            return "Aleatoria";
+        case SEL_CRITICAL:
+            return "Criticidade";
+        case SEL_PREDICTED:
+            return "Preditor de criticidade";
+        default:
+            return "Indice";
+    }
+}
+
+unsigned int res_pool_rob::get_select_count()
+{
+    return select_count;
+}
+
+unsigned int res_pool_rob::get_contention_count()
+{
+    return contention_count;
+}
+
+unsigned int res_pool_rob::get_changed_count()
+{
+    return changed_count;
+}
+
+unsigned int res_pool_rob::get_oldest_changed()
+{
+    return oldest_changed;
+}
+
+unsigned int res_pool_rob::priority(unsigned int i)
+{
+    return crit.predict(pc[i]);
+}
+
+crit_predictor &res_pool_rob::get_crit()
+{
+    return crit;
+}
+
+void res_pool_rob::set_bypass(unsigned int latency, bool partial, unsigned int miss)
+{
+    bypass_latency = latency;
+    bypass_partial = partial;
+    bypass_miss = miss;
+}
+
+unsigned int res_pool_rob::get_bypass_hits()
+{
+    return bypass_hits;
+}
+
+unsigned int res_pool_rob::get_bypass_misses()
+{
+    return bypass_misses;
+}
+
+// Ciclos extras ate o resultado do ROB tag poder ser usado pela estacao i
+unsigned int res_pool_rob::bypass_delay(int tag, unsigned int i)
+{
+    unsigned int delay = bypass_latency;
+    if(bypass_partial && (!tag_class.count(tag) || tag_class[tag] != class_of[i]))
+    {
+        bypass_misses++;
+        delay += bypass_miss;
+    }
+    else if(bypass_partial || bypass_latency)
+        bypass_hits++;
+    // Entre clusters o resultado sai do CDB local e atravessa a rede global
+    if(clusters > 1 && cluster_of[i] >= 0)
+    {
+        auto it = tag_cluster.find(tag);
+        if(it != tag_cluster.end() && it->second >= 0)
+        {
+            if(it->second != cluster_of[i])
+            {
+                cluster_cross++;
+                delay += cluster_delay;
+            }
+            else
+                cluster_local++;
+        }
+    }
+    return delay;
+}
+
+void res_pool_rob::set_clusters(unsigned int k, unsigned int delay, int st, const vector<unsigned int> &cls)
+{
+    if(k < 2)
+        return;
+    clusters = k;
+    cluster_delay = delay;
+    steer = st;
+    cluster_mask.assign(k,vector<uint64_t>(words,0));
+    cluster_issued.assign(k,0);
+    rr_next.assign(class_mask.size(),0);
+    // Estacoes de cada classe distribuidas alternadamente entre os clusters
+    for(unsigned int n = 0 ; n < cls.size() ; n++)
+    {
+        unsigned int idx = 0;
+        for(unsigned int i = 0 ; i < tam ; i++)
+            if(class_of[i] == (int)cls[n])
+            {
+                cluster_of[i] = idx % k;
+                cluster_mask[idx % k][i/64] |= (uint64_t)1 << (i%64);
+                idx++;
+            }
+    }
+    // Cada cluster recebe a sua parte das unidades funcionais limitadas, sem
+    // mudar o total. Com menos unidades que clusters elas nao sao divididas e
+    // todos os clusters as disputam; sem limite a estacao continua com a sua
+    unsigned int n_fu = fu_count.size();
+    cluster_fu.assign(n_fu,vector<int>(k));
+    for(unsigned int f = 0 ; f < n_fu ; f++)
+    {
+        unsigned int n = fu_count[f];
+        for(unsigned int c = 0 ; c < k ; c++)
+            if(n < k)
+                cluster_fu[f][c] = f;
+            else
+                cluster_fu[f][c] = add_fu(n/k + (c < n%k ? 1 : 0));
+    }
+}
+
+unsigned int res_pool_rob::get_clusters()
+{
+    return clusters;
+}
+
+int res_pool_rob::get_steer()
+{
+    return steer;
+}
+
+string res_pool_rob::steer_name(int steer)
+{
+    if(steer == STEER_DEPENDENCE)
+        return "Dependencia";
+    return "Rodizio";
+}
+
+void res_pool_rob::set_producer(string reg, unsigned int tag)
+{
+    if(clusters > 1)
+        reg_tag[reg] = tag;
+}
+
+// Esquece os produtores descartados pelo flush p; o tag pode ser reusado
+// por outra instrucao do caminho correto
+void res_pool_rob::flush_producers(const string &p)
+{
+    for(auto it = reg_tag.begin() ; it != reg_tag.end() ; )
+        if(flush_hits(p,it->second))
+            it = reg_tag.erase(it);
+        else
+            ++it;
+}
+
+int res_pool_rob::station_fu(int fu_cls, unsigned int i)
+{
+    if(clusters < 2 || fu_cls < 0 || fu_cls >= (int)cluster_fu.size() || cluster_of[i] < 0)
+        return fu_cls;
+    return cluster_fu[fu_cls][cluster_of[i]];
+}
+
+// Cluster da estacao que ainda vai produzir o valor de reg (-1 se nenhuma)
+int res_pool_rob::producer_cluster(const string &reg)
+{
+    auto it = reg_tag.find(reg);
+    if(it == reg_tag.end())
+        return -1;
+    for(unsigned int w = 0 ; w < words ; w++)
+    {
+        uint64_t m = busy_mask[w];
+        while(m)
+        {
+            unsigned int j = w*64 + __builtin_ctzll(m);
+            m &= m-1;
+            if(dest[j] == it->second)
+                return cluster_of[j];
+        }
+    }
+    return -1;
+}
+
+// Cluster com estacao livre da classe para a proxima instrucao (-1 se a
+// classe esta fora dos clusters ou nao ha estacao livre). Na escolha por
+// dependencia a instrucao vai para o cluster de um produtor pendente; sem
+// produtor, ou com o cluster dele cheio, vai para o cluster menos ocupado
+int res_pool_rob::steer_cluster(unsigned int cls, const vector<string> &src)
+{
+    vector<int> free_busy(clusters,-1);
+    vector<uint64_t> sel(words);
+    bool any = false;
+    for(unsigned int c = 0 ; c < clusters ; c++)
+    {
+        unsigned int busy = 0;
+        for(unsigned int w = 0 ; w < words ; w++)
+        {
+            sel[w] = class_mask[cls][w] & cluster_mask[c][w];
+            busy += __builtin_popcountll(busy_mask[w] & sel[w]);
+        }
+        if(first_set(busy_mask,sel,true) >= 0)
+        {
+            free_busy[c] = busy;
+            any = true;
+        }
+    }
+    if(!any)
+        return -1;
+    if(steer == STEER_DEPENDENCE)
+        for(unsigned int n = 0 ; n < src.size() ; n++)
+        {
+            int c = producer_cluster(src[n]);
+            if(c >= 0 && free_busy[c] >= 0)
+            {
+                steer_follow++;
+                rr_next[cls] = (c+1) % clusters;
+                return c;
+            }
+        }
+    int best = -1;
+    for(unsigned int k = 0 ; k < clusters ; k++)
+    {
+        unsigned int c = (rr_next[cls]+k) % clusters;
+        if(free_busy[c] < 0)
+            continue;
+        if(best == -1 || (steer == STEER_DEPENDENCE && free_busy[c] < free_busy[best]))
+            best = c;
+        if(steer == STEER_ROUND_ROBIN)
+            break;
+    }
+    rr_next[cls] = (best+1) % clusters;
+    return best;
+}
+
+unsigned int res_pool_rob::get_cluster_issued(unsigned int c)
+{
+    return c < cluster_issued.size() ? cluster_issued[c] : 0;
+}
+
+unsigned int res_pool_rob::get_cluster_local()
+{
+    return cluster_local;
+}
+
+unsigned int res_pool_rob::get_cluster_cross()
+{
+    return cluster_cross;
+}
+
+unsigned int res_pool_rob::get_steer_follow()
+{
+    return steer_follow;
+}
+
+void res_pool_rob::count_full_stall()
+{
+    full_stalls++;
+}
+
+unsigned int res_pool_rob::get_full_stalls()
+{
+    return full_stalls;
+}
+
+unsigned int res_pool_rob::get_window()
+{
+    return window;
+}
+
+unsigned int res_pool_rob::get_class_peak(unsigned int cls)
+{
+    return cls < class_peak.size() ? class_peak[cls] : 0;
+}
+
+double res_pool_rob::get_avg_occupancy()
+{
+    double area = occ_area + busy_count * (double)(sc_time_stamp() - occ_stamp).value();
+    double t = sc_time_stamp().value();
+    return t > 0 ? area/t : 0;
+}
+
+double res_pool_rob::get_class_avg_occupancy(unsigned int cls)
+{
+    if(cls >= class_area.size())
+        return 0;
+    double area = class_area[cls] + class_busy[cls] * (double)(sc_time_stamp() - occ_stamp).value();
+    double t = sc_time_stamp().value();
+    return t > 0 ? area/t : 0;
+}
+
+void res_pool_rob::set_vector(unsigned int n, unsigned int width)
+{
+    vlen = n ? n : 4;
+    vwidth = width && width < vlen ? width : vlen;
+}
+
+unsigned int res_pool_rob::get_vlen()
+{
+    return vlen;
+}
+
+unsigned int res_pool_rob::get_vwidth()
+{
+    return vwidth;
+}
+
+unsigned int res_pool_rob::latency(const string &op)
+{
+    //Instrucoes sem latencia propria usam a da escalar equivalente
+    static const map<string,string> scalar = {{"ADDV","DADD"},{"SUBV","DSUB"},{"MULV","DMUL"},{"SEQV","SLT"},{"SUMV","DADD"},{"MOVZ","DADD"},{"MOVN","DADD"}};
+    auto it = scalar.find(op);
+    if(it == scalar.end())
+        return instruct_time[op];
+    if(!is_vector_op(op))
+        return instruct_time[it->second];
+    unsigned int passes = (vlen + vwidth - 1)/vwidth;
+    unsigned int steps = 1;
+    //SUMV soma os elementos em arvore: log2(vlen) niveis de somadores
+    if(op == "SUMV")
+        while((1u << steps) < vlen)
+            steps++;
+    return instruct_time[it->second]*steps + passes - 1;
+}
+
+int res_pool_rob::select(const vector<uint64_t> &cand)
+{
+    int pick = -1;
+    unsigned int best = 0;
+    for(unsigned int w = 0 ; w < words ; w++)
+    {
+        uint64_t m = cand[w];
+        while(m)
+        {
+            unsigned int i = w*64 + __builtin_ctzll(m);
+            m &= m-1;
+            if(policy == SEL_INDEX)
+                return i;
+            if(policy == SEL_OLDEST)
+            {
+                if(is_oldest(i,cand))
+                    return i;
+            }
+            else
+            {
+                unsigned int score;
+                if(policy == SEL_RANDOM)
+                    score = rnd[i];
+                else if(policy == SEL_PREDICTED)
+                    score = crit.predict(pc[i]);
+                else
+                    score = dependents(i);
+                // Empate na criticidade fica com a mais antiga
+                if(pick == -1 || score > best || (score == best && ((older[pick][i/64] >> (i%64)) & 1)))
+                {
+                    pick = i;
+                    best = score;
+                }
+            }
+        }
+    }
+    return pick;
+}
+
+// Estacao i foi alocada antes de todas as outras candidatas
+bool res_pool_rob::is_oldest(unsigned int i, const vector<uint64_t> &cand)
+{
+    for(unsigned int k = 0 ; k < words ; k++)
+        if(older[i][k] & cand[k])
+            return false;
+    return true;
+}
+
+// Numero de instrucoes que aguardam o resultado da estacao i: estacoes
+// ocupadas ou em issue e, no ROB, desvios e stores
+unsigned int res_pool_rob::dependents(unsigned int i)
+{
+    unsigned int n = rob_waiting ? rob_waiting(dest[i]) : 0;
+    for(unsigned int w = 0 ; w < words ; w++)
+    {
+        uint64_t m = busy_mask[w] | issue_mask[w];
+        while(m)
+        {
+            unsigned int j = w*64 + __builtin_ctzll(m);
+            m &= m-1;
+            if(qj[j] == (int)dest[i] || qk[j] == (int)dest[i] || ql[j] == (int)dest[i])
+                n++;
+        }
+    }
+    return n;
+}
+
+int res_pool_rob::first_set(const vector<uint64_t> &mask, const vector<uint64_t> &sel, bool invert)
+{
+    for(unsigned int w = 0 ; w < words ; w++)
+    {
+        uint64_t m = (invert ? ~mask[w] : mask[w]) & sel[w];
+        if(m)
+            return w*64 + __builtin_ctzll(m);
+    }
+    return -1;
+}
@@ -0,0 +1,174 @@
+#pragma once
+#include<vector>
+#include<map>
+#include<string>
+#include<cstdint>
+#include<functional>
+#include<systemc.h>
+#include "crit_predictor.hpp"
+
+using std::vector;
+using std::map;
+using std::string;
+
+// Armazenamento de todas as estacoes de reserva do modo com especulacao
+// (add, mult e load) em vetores contiguos, um por campo (structure-of-arrays).
+// Ocupacao e prontidao ficam em mascaras de bits: a escolha de uma estacao
+// livre ou pronta custa um count-trailing-zeros por palavra de 64 estacoes.
+class res_pool_rob
+{
+public:
+    // Politicas de selecao entre estacoes prontas que disputam uma unidade
+    enum { SEL_INDEX, SEL_OLDEST, SEL_RANDOM, SEL_CRITICAL, SEL_PREDICTED };
+    // Politicas de escolha do cluster no issue
+    enum { STEER_ROUND_ROBIN, STEER_DEPENDENCE };
+
+    res_pool_rob(unsigned int n, map<string,int> inst_map, int policy = SEL_INDEX, unsigned int crit_size = 64);
+
+    unsigned int size();
+    // Define uma classe de estacoes com os indices [first,last)
+    unsigned int add_class(unsigned int first, unsigned int last);
+    // Estacao livre da classe; no modo em clusters, src sao os registradores
+    // fonte usados pela escolha do cluster por dependencia
+    int find_free(unsigned int cls, const vector<string> &src = vector<string>());
+    // Janela unificada: no maximo n estacoes ocupadas somando todas as classes
+    void set_window(unsigned int n);
+    bool is_unified();
+    // Limite de estacoes ocupadas da classe (0 = sem limite)
+    void set_class_limit(unsigned int cls, unsigned int n);
+    // Rede de bypass: latencia de entrega dos resultados e, no bypass parcial,
+    // apenas unidades da mesma classe se enxergam; as demais pagam miss ciclos
+    void set_bypass(unsigned int latency, bool partial, unsigned int miss);
+    unsigned int get_bypass_hits();
+    unsigned int get_bypass_misses();
+    // Divide as estacoes das classes cls em k clusters; um resultado entregue
+    // a outro cluster paga delay ciclos extras. As demais estacoes (load/store)
+    // ficam fora dos clusters, a mesma distancia de todos. Todos os clusters
+    // escrevem no mesmo CDB (um resultado por ciclo)
+    void set_clusters(unsigned int k, unsigned int delay, int steer, const vector<unsigned int> &cls);
+    unsigned int get_clusters();
+    static string steer_name(int steer);
+    int get_steer();
+    // Registrador reg sera escrito pelo ROB tag (tabela da escolha por dependencia)
+    void set_producer(string reg, unsigned int tag);
+    // Remove da tabela os tags descartados pela mensagem de flush p
+    void flush_producers(const string &p);
+    // Classe de unidade funcional da estacao i no seu cluster
+    int station_fu(int fu_cls, unsigned int i);
+    unsigned int get_cluster_issued(unsigned int c);
+    unsigned int get_cluster_local();
+    unsigned int get_cluster_cross();
+    unsigned int get_steer_follow();
+    int find_ready(unsigned int cls);
+    bool is_busy(unsigned int i);
+    void set_busy(unsigned int i, bool b);
+    // Estacao i recebendo uma instrucao: o issue ja publicou qj/qk/ql mas
+    // ainda le os operandos antes de ocupa-la; o wakeup tambem a consulta
+    void set_issuing(unsigned int i, bool b);
+    bool is_ready(unsigned int i);
+    void set_ready(unsigned int i, bool b);
+    // Entrega o valor do ROB tag aos operandos que o aguardam
+    void wakeup(int tag, float value, vector<unsigned int> &woken_j, vector<unsigned int> &woken_k, vector<unsigned int> &woken_l);
+
+    // Cria uma classe de unidades funcionais com n unidades (0 = uma por estacao)
+    unsigned int add_fu(unsigned int n);
+    // Tenta obter uma unidade funcional para a estacao i (que ja esta pronta);
+    // entre as prontas que disputam a unidade decide a politica de selecao
+    bool grant(unsigned int i);
+    // Libera a unidade funcional ocupada pela estacao i, se houver
+    void release(unsigned int i);
+    int get_policy();
+    static string policy_name(int policy);
+    // Dependentes fora das estacoes (no ROB) de um ROB tag, somados pela
+    // politica SEL_CRITICAL
+    void set_rob_waiting(std::function<unsigned int(unsigned int)> f);
+    unsigned int get_select_count();
+    unsigned int get_contention_count();
+    unsigned int get_changed_count();
+    // Selecoes com disputa em que a escolhida nao era a mais antiga
+    unsigned int get_oldest_changed();
+    // Prioridade da estacao i no CDB (1 = prevista como critica). O preditor
+    // de criticidade e treinado no wakeup e indexado pelo PC
+    unsigned int priority(unsigned int i);
+    crit_predictor &get_crit();
+    // Issue bloqueado por falta de estacao livre
+    void count_full_stall();
+    unsigned int get_full_stalls();
+    unsigned int get_window();
+    unsigned int get_class_peak(unsigned int cls);
+    double get_avg_occupancy();
+    double get_class_avg_occupancy(unsigned int cls);
+    // Instrucoes vetoriais: vlen elementos por registrador, width elementos
+    // processados por ciclo na unidade vetorial (0 = todos)
+    void set_vector(unsigned int vlen, unsigned int width);
+    unsigned int get_vlen();
+    unsigned int get_vwidth();
+    // Latencia da instrucao; nas vetoriais soma as passadas extras pelos
+    // elementos que nao cabem na largura da unidade. MOVZ/MOVN tem a do DADD
+    unsigned int latency(const string &op);
+
+    // Campos lidos no issue e no wakeup
+    vector<int> qj,qk;
+    vector<float> vj,vk;
+    vector<int> ql; //terceiro operando, usado apenas pela DFMA
+    vector<float> vl;
+    vector<string> lj,lk; //elementos dos operandos vetoriais ("" = escalar, replicado)
+    vector<unsigned int> dest;
+    // Campos lidos apenas na execucao
+    vector<unsigned int> a;
+    vector<unsigned int> instr_pos;
+    vector<char> fp;
+    vector<string> op;
+    vector<unsigned int> pc; //PC original da instrucao, indice do preditor de criticidade
+    vector<int> fu; //classe de unidade funcional da estacao (-1 = sem limite)
+    vector<sc_time> avail; //instante em que os operandos entregues pelo bypass podem ser usados
+    map<string,int> instruct_time;
+    sc_event fu_event; //notificado quando uma unidade funcional e ocupada ou liberada
+    sc_event free_event; //notificado quando uma estacao e liberada
+    // Flushes vistos pelo buffer de loads; vai nos pedidos de load para a
+    // memoria descartar os do caminho que um flush posterior esvaziou
+    unsigned int flush_gen;
+
+private:
+    unsigned int tam,words;
+    int policy;
+    vector<uint64_t> busy_mask,ready_mask,issue_mask;
+    vector<vector<uint64_t> > class_mask;
+    vector<int> class_of; //classe de cada estacao
+    vector<unsigned int> class_limit,class_busy,class_peak;
+    unsigned int window,busy_count,full_stalls;
+    double occ_area; //integral da ocupacao no tempo, para a media
+    vector<double> class_area; //a mesma integral por classe
+    sc_time occ_stamp;
+    // Matriz de idade: older[i] tem os bits das estacoes alocadas antes de i
+    vector<vector<uint64_t> > older;
+    vector<unsigned int> rnd; //prioridade sorteada quando a estacao fica pronta
+    vector<unsigned int> fu_count,fu_busy;
+    vector<char> holds_fu;
+    crit_predictor crit;
+    map<unsigned int,unsigned int> tag_pc; //PC da instrucao que produz cada ROB tag
+    map<unsigned int,int> tag_class; //classe da estacao que produz cada ROB tag
+    unsigned int bypass_latency,bypass_miss,bypass_hits,bypass_misses;
+    bool bypass_partial;
+    unsigned int clusters,cluster_delay;
+    int steer;
+    vector<int> cluster_of; //cluster de cada estacao (-1 = fora dos clusters)
+    vector<vector<uint64_t> > cluster_mask;
+    map<unsigned int,int> tag_cluster; //cluster da estacao que produz cada ROB tag
+    map<string,unsigned int> reg_tag; //ultimo ROB tag a escrever cada registrador
+    vector<vector<int> > cluster_fu; //classe de unidade por [classe original][cluster]
+    vector<unsigned int> rr_next; //proximo cluster do rodizio, por classe
+    vector<unsigned int> cluster_issued;
+    unsigned int cluster_local,cluster_cross,steer_follow;
+    unsigned int select_count,contention_count,changed_count,oldest_changed;
+    std::function<unsigned int(unsigned int)> rob_waiting;
+    unsigned int vlen,vwidth;
+
+    int first_set(const vector<uint64_t> &mask, const vector<uint64_t> &sel, bool invert);
+    int select(const vector<uint64_t> &cand);
+    bool is_oldest(unsigned int i, const vector<uint64_t> &cand);
+    unsigned int dependents(unsigned int i);
+    unsigned int bypass_delay(int tag, unsigned int i);
+    int steer_cluster(unsigned int cls, const vector<string> &src);
+    int producer_cluster(const string &reg);
+};
@@ -1,39 +1,50 @@
 #include "res_station_rob.hpp"
 #include "general.hpp"
+#include<cmath>
 
 
-res_station_rob::res_station_rob(sc_module_name name,int i, string n,bool isMem, map<string,int> inst_map, const nana::listbox::item_proxy item, const nana::listbox::cat_proxy c, const nana::listbox::cat_proxy rgui):
+res_station_rob::res_station_rob(sc_module_name name,int i, string n,bool isMem, res_pool_rob &p, unsigned int pos, const nana::listbox::item_proxy item, const nana::listbox::cat_proxy c, const nana::listbox::cat_proxy rgui):
 sc_module(name),
 id(i),
+idx(pos),
 type_name(n),
 isMemory(isMem),
-instruct_time(inst_map),
+pool(p),
 table_item(item),
 instr_queue_gui(c),
 rob_gui(rgui)
 {
-    Busy = isFlushed = false;
-    vj = vk = qj = qk = a = 0;
+    isFlushed = running = false;
     SC_THREAD(exec);
     sensitive << exec_event;
     dont_initialize();
-    SC_METHOD(leitura);
-    sensitive << in;
-    dont_initialize();
 }
 
 void res_station_rob::exec()
 {
     while(true)
     {
+        running = true;
         //Enquanto houver dependencia de valor em outra RS, espere
-        while(qj || qk)
+        while(pool.qj[idx] || pool.qk[idx] || pool.ql[idx])
             wait(val_enc | isFlushed_event);
+        //Operando ainda atravessando a rede de bypass
+        if(!isFlushed && pool.avail[idx] > sc_time_stamp())
+            wait(pool.avail[idx] - sc_time_stamp(),isFlushed_event);
+        //Aguarda ser escolhida pela politica de selecao para uma unidade funcional livre
+        while(!isFlushed && !pool.grant(idx))
+            wait(pool.fu_event | isFlushed_event);
         wait(SC_ZERO_TIME);
         wait(SC_ZERO_TIME);
         if(!isFlushed)
         {
             float res = 0;
+            string lanes; //resultado das instrucoes vetoriais
+            string &op = pool.op[idx];
+            float vj = pool.vj[idx];
+            float vk = pool.vk[idx];
+            unsigned int dest = pool.dest[idx];
+            unsigned int instr_pos = pool.instr_pos[idx];
             cout << "Execuçao da instruçao " << op << " iniciada no ciclo " << sc_time_stamp() << " em " << name() << endl << flush;
             if(!isMemory){ //Se for store ou load, ja foi setado pelo address_unit
                 if(instr_pos < instr_queue_gui.size())
@@ -46,6 +57,12 @@ void res_station_rob::exec()
                 res = vj - vk;
             else if(op.substr(0,4) == "DMUL")
                 res = vj*vk;
+            else if(op == "DFMA") //multiplica e soma com um unico arredondamento
+                res = std::fma(vj,vk,pool.vl[idx]);
+            else if(op == "MOVZ") //sem a condicao o destino fica com o valor antigo
+                res = vk == 0 ? vj : pool.vl[idx];
+            else if(op == "MOVN")
+                res = vk != 0 ? vj : pool.vl[idx];
             else if(op.substr(0,4) == "DDIV")
             {
                 if(vk)
@@ -55,10 +72,32 @@ void res_station_rob::exec()
             }
             else if(isMemory)
             {
-                a += vk;
-                table_item->text(A,std::to_string(a));
+                pool.a[idx] += vk;
+                table_item->text(A,std::to_string(pool.a[idx]));
                 table_item->text(VK,"");
             }
+            else if(is_vector_op(op))
+            {
+                //Elemento a elemento; um operando escalar vale para todos os elementos
+                unsigned int n = pool.get_vlen();
+                vector<int> a = pool.lj[idx] == "" ? vector<int>(n,(int)vj) : lanes_split(pool.lj[idx],n);
+                vector<int> b = pool.lk[idx] == "" ? vector<int>(n,(int)vk) : lanes_split(pool.lk[idx],n);
+                for(unsigned int e = 0 ; e < n ; e++)
+                {
+                    if(op == "ADDV")
+                        a[e] += b[e];
+                    else if(op == "SUBV")
+                        a[e] -= b[e];
+                    else if(op == "MULV")
+                        a[e] *= b[e];
+                    else if(op == "SEQV")
+                        a[e] = a[e] == b[e];
+                    else //SUMV: soma dos elementos em um registrador escalar
+                        res += a[e];
+                }
+                if(op != "SUMV")
+                    lanes = lanes_join(a);
+            }
             else if(op.substr(0,3) == "SLT")
             {
                 if(vj < vk){
@@ -77,75 +116,55 @@ void res_station_rob::exec()
             }
             if(!isMemory)
             {
-                wait(sc_time(instruct_time[op],SC_NS),isFlushed_event);
+                wait(sc_time(pool.latency(op),SC_NS),isFlushed_event);
                 wait(SC_ZERO_TIME);
+                pool.release(idx);
                 if(!isFlushed)
                 {
                     string escrita_saida,rs;
-                    if(fp)
+                    if(lanes != "")
+                        rs = lanes;
+                    else if(pool.fp[idx])
                         rs = std::to_string(res);
                     else
                         rs = std::to_string((int)res);
                     escrita_saida = std::to_string(dest) + ' ' + rs;
                     cout << "Instrucao " << op << " completada no ciclo " << sc_time_stamp() << " em " << name() << " com resultado " << res << endl << flush;
-                    out->write(escrita_saida);
+                    out->write(escrita_saida,pool.priority(idx));
                 }
             }
             else if(!isFlushed)
             {
-                if(op.at(0) == 'L')
-                    mem_req(true,a,dest);
+                if(op == "LV")
+                    out_mem->write("LV " + std::to_string(pool.a[idx]) + ' ' + std::to_string(dest) + ' ' + std::to_string(pool.flush_gen));
+                else if(op == "PREF")
+                    out_mem->write("PF " + std::to_string(pool.a[idx]) + ' ' + std::to_string(dest) + ' ' + std::to_string(pool.flush_gen));
+                else if(op.at(0) == 'L')
+                    mem_req(true,pool.a[idx],dest,op == "LLD");
                 else
                 {
-                    mem_req(false,a,vj);
-                    cout << "Instrucao " << op << " completada no ciclo " << sc_time_stamp() << " em " << name() << " gravando na posicao de memoria " << a << " o resultado " << vj << endl << flush;
+                    mem_req(false,pool.a[idx],vj);
+                    cout << "Instrucao " << op << " completada no ciclo " << sc_time_stamp() << " em " << name() << " gravando na posicao de memoria " << pool.a[idx] << " o resultado " << vj << endl << flush;
                 }
-                a = 0;
+                pool.a[idx] = 0;
             }
         }
         wait(SC_ZERO_TIME);
         if(!isFlushed){
-            if(instr_pos < instr_queue_gui.size())
-                instr_queue_gui.at(instr_pos).text(WRITE,std::to_string(sc_time_stamp().value() / 1000)); //text(WRITE,"X");
+            if(pool.instr_pos[idx] < instr_queue_gui.size())
+                instr_queue_gui.at(pool.instr_pos[idx]).text(WRITE,std::to_string(sc_time_stamp().value() / 1000)); //text(WRITE,"X");
         }
         
-        Busy = isFlushed = false;
+        pool.release(idx);
+        pool.set_busy(idx,false);
+        isFlushed = false;
         cout << "estacao " << id << " liberada no ciclo " << sc_time_stamp() << endl << flush;
         clean_item(); //Limpa a tabela na interface grafica
+        running = false;
         wait();
     }
 }
 
-void res_station_rob::leitura()
-{
-    in->read(p);
-    if(qj || qk)
-    {
-        int rs_source;
-        in->read(p);
-        ord = instruction_split(p);
-        rs_source = std::stoi(ord[0]);
-        if(qj == rs_source)
-        {
-            qj = 0;
-            vj = std::stoi(ord[1]);
-            table_item->text(VJ,ord[1]);
-            table_item->text(QJ,"");
-            cout << "Instrucao " << op << " conseguiu o valor " << vj << " da RS_" << rs_source << endl << flush; 
-            val_enc.notify(1,SC_NS);
-        }
-        if(qk == rs_source)
-        {
-            qk = 0;
-            vk = std::stoi(ord[1]);
-            table_item->text(VK,ord[1]);
-            table_item->text(QK,"");
-            cout << "Instrucao " << op << " conseguiu o valor " << vk << " da RS_" << rs_source << endl << flush; 
-            val_enc.notify(1,SC_NS);
-        }
-    }
-}
-
 void res_station_rob::clean_item()
 {
     for(unsigned i = 2 ; i < table_item->columns(); i++)
@@ -153,12 +172,12 @@ void res_station_rob::clean_item()
     table_item->text(BUSY,"False");
 }
 
-void res_station_rob::mem_req(bool load,unsigned int addr,int value)
+void res_station_rob::mem_req(bool load,unsigned int addr,int value,bool link)
 {
     string escrita_saida;
     string temp = std::to_string(addr) + ' ' + std::to_string(value);
     if(load)
-        escrita_saida = "L " + temp;
+        escrita_saida = (link ? "LL " : "L ") + temp + ' ' + std::to_string(pool.flush_gen);
     else
         escrita_saida = "S " + temp;
     out_mem->write(escrita_saida);
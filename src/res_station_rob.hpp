@@ -1,5 +1,6 @@
 #pragma once
 #include "interfaces.hpp"
+#include "res_pool_rob.hpp"
 #include<nana/gui/widgets/listbox.hpp>
 #include<vector>
 #include<map>
@@ -11,36 +12,25 @@ class res_station_rob: public sc_module
 {
 public:
     int id;
-    unsigned int dest;
+    unsigned int idx; //posicao da estacao no res_pool_rob
     string type_name;
-    bool Busy;
     bool isFlushed;
+    bool running; //exec em andamento: a propria estacao se libera no fim
     bool isMemory;
-    bool fp;
-    string op;
-    float vj,vk;
-    int qj,qk;
-    unsigned int a;
-    unsigned int instr_pos;
-    map<string,int> instruct_time;
-    sc_port<write_if> out;
-    sc_port<read_if> in;
+    sc_port<prio_write_if> out;
     sc_port<write_if> out_mem;
-    sc_event exec_event,isFlushed_event;
+    sc_event exec_event,isFlushed_event,val_enc;
     SC_HAS_PROCESS(res_station_rob);
 
-    res_station_rob(sc_module_name name,int i, string n, bool isMem, map<string,int> inst_map, const nana::listbox::item_proxy item, const nana::listbox::cat_proxy c, const nana::listbox::cat_proxy rgui);
+    res_station_rob(sc_module_name name,int i, string n, bool isMem, res_pool_rob &p, unsigned int pos, const nana::listbox::item_proxy item, const nana::listbox::cat_proxy c, const nana::listbox::cat_proxy rgui);
     void exec();
-    void leitura();
     void clean_item();
 
 private:
-    string p;
-    vector<string> ord;
-    sc_event val_enc;
+    res_pool_rob &pool;
     nana::listbox::item_proxy table_item;
     const nana::listbox::cat_proxy instr_queue_gui;
     const nana::listbox::cat_proxy rob_gui;
 
-    void mem_req(bool load,unsigned int addr,int value);
+    void mem_req(bool load,unsigned int addr,int value,bool link = false);
 };
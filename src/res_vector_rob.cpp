@@ -1,17 +1,20 @@
 #include "res_vector_rob.hpp"
 #include "general.hpp"
 
-res_vector_rob::res_vector_rob(sc_module_name name,unsigned int t1, unsigned int t2,map<string,int> instruct_time, nana::listbox &lsbox, nana::listbox::cat_proxy ct, nana::listbox::cat_proxy r_ct):
+res_vector_rob::res_vector_rob(sc_module_name name,unsigned int t1, unsigned int t2,res_pool_rob &p, nana::listbox &lsbox, nana::listbox::cat_proxy ct, nana::listbox::cat_proxy r_ct):
 sc_module(name),
+pool(p),
 table(lsbox)
 {
-    res_type = {{"DADD",0},{"DADDI",0},{"DADDU",0},{"DADDIU",0},{"DSUB",0},{"DSUBU",0},{"DMUL",1},{"DMULU",1},{"DDIV",1},{"DDIVU",1}};
+    res_type = {{"DADD",0},{"DADDI",0},{"DADDU",0},{"DADDIU",0},{"DSUB",0},{"DSUBU",0},{"DMUL",1},{"DMULU",1},{"DDIV",1},{"DDIVU",1},{"DFMA",1},{"MOVZ",0},{"MOVN",0},{"ADDV",0},{"SUBV",0},{"SEQV",0},{"SUMV",0},{"MULV",1}};
+    fma_fu = vec_fu = 1;
     auto cat = table.at(0);
     string texto;
     rs.resize(t1+t2);
-    tam_pos[0] = 0;
-    tam_pos[1] = t1;
-    tam_pos[2] = t1+t2;
+    isFlushed = false;
+    issue_tag = 0;
+    rs_class[0] = pool.add_class(0,t1);
+    rs_class[1] = pool.add_class(t1,t1+t2);
     for(unsigned int i = 0 ; i < t1+t2 ; i++)
     {
         if(i < t1)
@@ -19,8 +22,7 @@ table(lsbox)
         else
             texto = "Mult" + std::to_string(i-t1+1);
         cat.append({std::to_string(cat.size()+1),texto,"False"});
-        rs[i] = new res_station_rob(texto.c_str(),i+1,texto,false,instruct_time,cat.at(i),ct,r_ct);
-        rs[i]->in(in_cdb);
+        rs[i] = new res_station_rob(texto.c_str(),i+1,texto,false,pool,i,cat.at(i),ct,r_ct);
         rs[i]->out(out_cdb);
         rs[i]->out_mem(out_mem);
     }
@@ -30,6 +32,9 @@ table(lsbox)
     SC_METHOD(leitura_rob);
     sensitive << in_rob;
     dont_initialize();
+    SC_METHOD(leitura_cdb);
+    sensitive << in_cdb;
+    dont_initialize();
 }
 
 res_vector_rob::~res_vector_rob()
@@ -45,6 +50,7 @@ void res_vector_rob::leitura_issue()
     int pos,rob_pos;
     int regst;
     float value;
+    string text;
     bool check_value;
     auto cat = table.at(0);
     while(true)
@@ -59,42 +65,76 @@ void res_vector_rob::leitura_issue()
            
         in_issue->nb_read(p);
         ord = instruction_split(p);
-        pos = busy_check(ord[0]);
-        while(pos == -1)
+        issue_tag = std::stoi(ord[ord.size() - 1]);
+        pos = busy_check(ord);
+        isFlushed = false;
+        if(pos == -1)
+            pool.count_full_stall();
+        while(pos == -1 && !isFlushed)
         {
             cout << "Todas as estacoes ocupadas para a instrucao " << p << endl << flush;
-            wait(in_cdb->default_event());
+            //Na janela unificada a entrada pode ser liberada por um load ou store
+            if(pool.is_unified())
+                wait(pool.free_event | flush_event);
+            else
+                wait(in_cdb->default_event() | flush_event);
             wait(1,SC_NS);
-            pos = busy_check(ord[0]);
+            pos = busy_check(ord);
         }
         in_issue->notify();
+        //Instrucao descartada pelo flush do ROB enquanto aguardava estacao livre
+        if(isFlushed)
+        {
+            cout << "Instrucao " << p << " descartada pelo flush" << endl << flush;
+            wait_issue();
+            continue;
+        }
         cout << "Issue da instrução " << ord[0] << " no ciclo " << sc_time_stamp() << " para " << rs[pos]->type_name << endl << flush;
         // Anteriormente era ord[5]
         // Acréscimo devido à informação adicional (pc_original_instruction)
         // Feita em instruction_queue_rob.cpp
         rob_pos = std::stoi(ord[ord.size() - 1]); //Pode ser ord[6], last position
-        rs[pos]->op = ord[0];
-        rs[pos]->fp = ord[0].at(0) == 'F';
-        rs[pos]->dest = rob_pos;
-        rs[pos]->instr_pos = std::stoi(ord[4]);
+        pool.set_issuing(pos,true);
+        pool.op[pos] = ord[0];
+        //Resultado em ponto flutuante quando o destino e um registrador PF
+        //(DFMA F1,F2,F3,F4); com destino inteiro e truncado
+        pool.fp[pos] = ord[1].at(0) == 'F';
+        if(ord[0] == "DFMA")
+            pool.fu[pos] = pool.station_fu(fma_fu,pos);
+        else if(is_vector_op(ord[0]))
+            pool.fu[pos] = pool.station_fu(vec_fu,pos);
+        else
+            pool.fu[pos] = pool.station_fu(res_type[ord[0]],pos);
+        pool.lj[pos] = pool.lk[pos] = "";
+        pool.dest[pos] = rob_pos;
+        pool.instr_pos[pos] = std::stoi(ord[ord.size() - 3]);
+        pool.pc[pos] = std::stoi(ord[ord.size() - 2]);
         regst = ask_status(ord[2]);
         cat.at(pos).text(OP,ord[0]);
         check_value = false;
         if(regst != 0)
         {
-            string check = ask_rob_value(std::to_string(regst));
-            if(check != "EMPTY")
+            text = ask_rob_value(std::to_string(regst));
+            if(text != "EMPTY")
             {
-                value = std::stof(check);
+                value = std::stof(text);
                 check_value = true;
             }
         }
         if(regst == 0 || check_value == true)
         {
             if(check_value == false)
-                value = ask_value(ord[2]);
-            rs[pos]->vj = value;
-            if(ord[2].at(0) == 'R')
+            {
+                text = ask_text(ord[2]);
+                value = std::stof(text);
+            }
+            pool.vj[pos] = value;
+            if(ord[2].at(0) == 'V')
+            {
+                pool.lj[pos] = text;
+                cat.at(pos).text(VJ,text);
+            }
+            else if(ord[2].at(0) == 'R')
                 cat.at(pos).text(VJ,std::to_string((int)value));
             else
                 cat.at(pos).text(VJ,std::to_string(value));
@@ -102,25 +142,27 @@ void res_vector_rob::leitura_issue()
         else
         {
             cout << "instruçao " << ord[0] << " aguardando reg " << ord[2] << endl << flush;
-            rs[pos]->qj = regst;
+            pool.qj[pos] = regst;
             cat.at(pos).text(QJ,std::to_string(regst));
         }
         if(ord[0].at(ord[0].size()-1) == 'I')
         {
             value = std::stof(ord[3]);
-            rs[pos]->vk = value;
+            pool.vk[pos] = value;
             cat.at(pos).text(VK,std::to_string((int)value));
         }
+        else if(ord[0] == "SUMV") //um unico operando
+            pool.vk[pos] = 0;
         else 
         {
             check_value = false;
             regst = ask_status(ord[3]);
             if(regst != 0)
             {
-                string check = ask_rob_value(std::to_string(regst));
-                if(check != "EMPTY")
+                text = ask_rob_value(std::to_string(regst));
+                if(text != "EMPTY")
                 {
-                    value = std::stof(check);
+                    value = std::stof(text);
                     check_value = true;
                 }
             }
@@ -128,9 +170,17 @@ void res_vector_rob::leitura_issue()
             if(regst == 0 || check_value == true)
             {
                 if(check_value == false)
-                    value = ask_value(ord[3]);
-                rs[pos]->vk = value;
-                if(ord[3].at(0) == 'R')
+                {
+                    text = ask_text(ord[3]);
+                    value = std::stof(text);
+                }
+                pool.vk[pos] = value;
+                if(ord[3].at(0) == 'V')
+                {
+                    pool.lk[pos] = text;
+                    cat.at(pos).text(VK,text);
+                }
+                else if(ord[3].at(0) == 'R')
                     cat.at(pos).text(VK,std::to_string((int)value));
                 else
                     cat.at(pos).text(VK,std::to_string(value));
@@ -138,64 +188,169 @@ void res_vector_rob::leitura_issue()
             else
             {
                 cout << "instruçao " << ord[0] << " aguardando reg " << ord[3] << endl << flush;
-                rs[pos]->qk = regst;
+                pool.qk[pos] = regst;
                 cat.at(pos).text(QK,std::to_string(regst));
             }
         }
+        //Terceiro operando, sem coluna na tabela: a parcela somada da DFMA e o
+        //valor antigo do destino de MOVZ/MOVN, mantido se a condicao falha
+        if(ord[0] == "DFMA" || ord[0] == "MOVZ" || ord[0] == "MOVN")
+        {
+            string third = ord[0] == "DFMA" ? ord[4] : ord[1];
+            check_value = false;
+            regst = ask_status(third);
+            if(regst != 0)
+            {
+                string check = ask_rob_value(std::to_string(regst));
+                if(check != "EMPTY")
+                {
+                    value = std::stof(check);
+                    check_value = true;
+                }
+            }
+            if(regst == 0 || check_value == true)
+            {
+                if(check_value == false)
+                    value = ask_value(third);
+                pool.vl[pos] = value;
+            }
+            else
+            {
+                cout << "instruçao " << ord[0] << " aguardando reg " << third << endl << flush;
+                pool.ql[pos] = regst;
+            }
+        }
         wait(SC_ZERO_TIME);
+        //Flush do ROB durante a leitura dos operandos: a estacao nao e ocupada
+        if(isFlushed)
+        {
+            pool.qj[pos] = pool.qk[pos] = pool.ql[pos] = 0;
+            pool.set_issuing(pos,false);
+            for(unsigned int k = 3 ; k < cat.at(pos).columns() ; k++)
+                cat.at(pos).text(k,"");
+            cout << "Instrucao " << p << " descartada pelo flush" << endl << flush;
+            wait_issue();
+            continue;
+        }
         out_rob->write("N");
-        rs[pos]->Busy = true;
+        pool.set_producer(ord[1],rob_pos);
+        pool.set_busy(pos,true);
+        pool.set_ready(pos,!pool.qj[pos] && !pool.qk[pos] && !pool.ql[pos]);
         cat.at(pos).text(BUSY,"True");
         rs[pos]->exec_event.notify(1,SC_NS);
-        wait();
+        wait_issue();
     }
 }
 
+//Espera o proximo issue, que pode ter chegado enquanto as estacoes liam
+//os operandos de uma instrucao descartada pelo flush
+void res_vector_rob::wait_issue()
+{
+    string p = "";
+    in_issue->nb_read(p);
+    if(p == "")
+        wait();
+}
+
 void res_vector_rob::leitura_rob()
 {
     string p;
     in_rob->nb_read(p);
-    if(p == "F")
+    if(is_flush(p))
     {        
         in_rob->notify(); // O barramento espera uma notificação de que foi lido
         auto cat = table.at(0);
         for(unsigned int i = 0 ; i < rs.size() ; i++)
         {
-            if(rs[i]->Busy)
+            if(pool.is_busy(i) && flush_hits(p,pool.dest[i]))
             {
                 auto table_item = cat.at(i);
                 rs[i]->isFlushed = true;
-                rs[i]->qj = rs[i]->qk = 0;
+                pool.qj[i] = pool.qk[i] = pool.ql[i] = 0;
                 table_item.text(BUSY,"False");
                 for(unsigned int k = 3 ; k < table_item.columns() ; k++)
                     table_item.text(k,"");
                 rs[i]->isFlushed_event.notify();
             }
         }
+        pool.flush_producers(p);
+        //Flush de outra thread nao descarta a instrucao em issue
+        if(flush_hits(p,issue_tag))
+            isFlushed = true;
+        //No SMT o flush de uma thread pode liberar a estacao que o issue da
+        //outra aguarda; acorda o issue sempre, senao ele fica preso
+        flush_event.notify();
     }
 }
 
-int res_vector_rob::busy_check(string inst)
+void res_vector_rob::leitura_cdb()
 {
-    unsigned int inst_type = res_type[inst];
-    for(unsigned int i = tam_pos[inst_type] ; i < tam_pos[inst_type + 1] ; i++)
-        if(!rs[i]->Busy)
-            return i;
-    return -1;
+    string p;
+    vector<string> ord;
+    vector<unsigned int> woken_j,woken_k,woken_l;
+    auto cat = table.at(0);
+    in_cdb->read(p);
+    ord = instruction_split(p);
+    int rs_source = std::stoi(ord[0]);
+    pool.wakeup(rs_source,std::stof(ord[1]),woken_j,woken_k,woken_l);
+    //Resultado vetorial: os elementos vao junto com o valor
+    bool vec = ord[1].find(':') != string::npos;
+    for(unsigned int i = 0 ; i < woken_j.size() ; i++)
+    {
+        if(vec)
+            pool.lj[woken_j[i]] = ord[1];
+        cat.at(woken_j[i]).text(VJ,ord[1]);
+        cat.at(woken_j[i]).text(QJ,"");
+        cout << "Instrucao " << pool.op[woken_j[i]] << " conseguiu o valor " << pool.vj[woken_j[i]] << " da RS_" << rs_source << endl << flush;
+        rs[woken_j[i]]->val_enc.notify(1,SC_NS);
+    }
+    for(unsigned int i = 0 ; i < woken_k.size() ; i++)
+    {
+        if(vec)
+            pool.lk[woken_k[i]] = ord[1];
+        cat.at(woken_k[i]).text(VK,ord[1]);
+        cat.at(woken_k[i]).text(QK,"");
+        cout << "Instrucao " << pool.op[woken_k[i]] << " conseguiu o valor " << pool.vk[woken_k[i]] << " da RS_" << rs_source << endl << flush;
+        rs[woken_k[i]]->val_enc.notify(1,SC_NS);
+    }
+    for(unsigned int i = 0 ; i < woken_l.size() ; i++)
+    {
+        cout << "Instrucao " << pool.op[woken_l[i]] << " conseguiu o valor " << pool.vl[woken_l[i]] << " da RS_" << rs_source << endl << flush;
+        rs[woken_l[i]]->val_enc.notify(1,SC_NS);
+    }
+}
+
+void res_vector_rob::set_fma_fu(unsigned int fu)
+{
+    fma_fu = fu;
+}
+
+void res_vector_rob::set_vec_fu(unsigned int fu)
+{
+    vec_fu = fu;
+}
+
+int res_vector_rob::busy_check(const vector<string> &ord)
+{
+    return pool.find_free(rs_class[res_type[ord[0]]],{ord[2],ord[3]});
 }
 float res_vector_rob::ask_value(string reg)
+{
+    return std::stof(ask_text(reg));
+}
+string res_vector_rob::ask_text(string reg)
 {
     string res;
     out_rb->write("R V " + reg);
     in_rb->read(res);
-    return std::stof(res);
+    return res;
 }
 string res_vector_rob::ask_rob_value(string rob_pos)
 {
     string res;
     out_rob->write(rob_pos);
     in_rob->nb_read(res);
-    while(res == "F")
+    while(is_flush(res))
         wait(out_rob->default_event());
     in_rob->notify();
     return res;
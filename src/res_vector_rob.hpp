@@ -1,5 +1,6 @@
 #include "interfaces.hpp"
 #include "res_station_rob.hpp"
+#include "res_pool_rob.hpp"
 #include<map>
 #include<vector>
 #include<nana/gui/widgets/listbox.hpp>
@@ -13,25 +14,38 @@ public:
     vector<res_station_rob *> rs;
     sc_port<read_if_f> in_issue;
     sc_port<read_if> in_cdb;
-    sc_port<write_if> out_cdb;
+    sc_port<prio_write_if> out_cdb;
     sc_port<read_if_f> in_rb;
     sc_port<write_if_f> out_rb;
     sc_port<write_if> out_mem;
     sc_port<read_if_f> in_rob;
     sc_port<write_if_f> out_rob;
     SC_HAS_PROCESS(res_vector_rob);
-    res_vector_rob(sc_module_name name,unsigned int t1, unsigned int t2,map<string,int> instruct_time, nana::listbox &lsbox, nana::listbox::cat_proxy ct, nana::listbox::cat_proxy r_ct);
+    res_vector_rob(sc_module_name name,unsigned int t1, unsigned int t2,res_pool_rob &p, nana::listbox &lsbox, nana::listbox::cat_proxy ct, nana::listbox::cat_proxy r_ct);
     ~res_vector_rob();
     void leitura_issue();
     void leitura_rob();
+    void leitura_cdb();
+    // Classe de unidade funcional da DFMA (padrao: as unidades MUL)
+    void set_fma_fu(unsigned int fu);
+    // Classe de unidade funcional das instrucoes vetoriais
+    void set_vec_fu(unsigned int fu);
 private:
     map<string,int> res_type;
-    unsigned int tam_pos[3];
+    unsigned int rs_class[2]; //classes de estacoes (add e mult) no res_pool_rob
+    unsigned int fma_fu,vec_fu;
+    res_pool_rob &pool;
+    bool isFlushed; //flush ocorreu enquanto o issue aguardava estacao livre
+    unsigned int issue_tag; //entrada do ROB da instrucao em issue
+    sc_event flush_event;
     nana::listbox &table;
     //sc_event robFlushed;
 
-    int busy_check(string inst);
+    int busy_check(const vector<string> &ord);
     float ask_value(string reg);
+    // Valor do registrador como texto (elementos de um registrador V)
+    string ask_text(string reg);
     string ask_rob_value(string rob_pos);
     unsigned int ask_status(string reg);
+    void wait_issue();
 };
@@ -0,0 +1,249 @@
+#include "runahead.hpp"
+#include "general.hpp"
+#include<cmath>
+
+runahead::runahead(vector<string> program, nana::listbox &regs, nana::grid &mem, data_cache &cache):
+program(program),
+regs(regs),
+mem(mem),
+cache(cache)
+{
+    running = false;
+    pc = 0;
+    episodes = cycles = executed = invalid = 0;
+}
+
+void runahead::start(unsigned int load_pc, string dest)
+{
+    auto cat = regs.at(0);
+    running = true;
+    episodes++;
+    pc = load_pc + 1;
+    ra_cache.clear();
+    for(unsigned int i = 0 ; i < 32 && i < cat.size() ; i++)
+    {
+        string r = cat.at(i).text(1);
+        string f = cat.at(i).text(4);
+        reg_file["R" + std::to_string(i)] = {true,r != "" ? std::stof(r) : 0};
+        reg_file["F" + std::to_string(i)] = {true,f != "" ? std::stof(f) : 0};
+    }
+    reg_file[dest] = {false,0};
+}
+
+int runahead::step(sc_time now)
+{
+    if(!running)
+        return -1;
+    cycles++;
+    if(pc >= program.size())
+        return -1;
+    vector<string> ord = instruction_split(program[pc]);
+    unsigned int cur = pc++;
+    string op = ord[0];
+    executed++;
+    if(op == "J")
+    {
+        pc = cur + std::stoi(ord[1]);
+        return -1;
+    }
+    //LOOP: o contador fica na busca; o runahead segue o laco
+    if(op == "LOOP")
+    {
+        pc = cur + std::stoi(ord[2]);
+        return -1;
+    }
+    if(op.at(0) == 'B')
+    {
+        bool two = op == "BEQ" || op == "BNE";
+        ra_value a = read(ord[1]);
+        ra_value b = two ? read(ord[2]) : ra_value{true,0};
+        int offset = std::stoi(ord[two ? 3 : 2]);
+        bool taken;
+        if(!a.valid || !b.valid)
+        {
+            invalid++;
+            taken = offset < 0;
+        }
+        else if(op == "BEQ")
+            taken = (int)a.value == (int)b.value;
+        else if(op == "BNE")
+            taken = (int)a.value != (int)b.value;
+        else if(op == "BGTZ")
+            taken = a.value > 0;
+        else if(op == "BLTZ")
+            taken = a.value < 0;
+        else if(op == "BGEZ")
+            taken = a.value >= 0;
+        else
+            taken = a.value <= 0;
+        if(taken)
+            pc = cur + offset;
+        return -1;
+    }
+    //Vetoriais: os registradores V nao sao seguidos; o LV ainda antecipa a
+    //linha do primeiro elemento e a soma do SUMV fica INV
+    if(is_vector_op(op))
+    {
+        if(op == "SUMV")
+            reg_file[ord[1]] = {false,0};
+        if(op != "LV")
+            return -1;
+        unsigned int par = ord[2].find('(');
+        ra_value base = read(ord[2].substr(par+1,ord[2].size()-par-2));
+        unsigned int addr = std::stoi(ord[2].substr(0,par)) + (int)base.value;
+        if(!base.valid)
+        {
+            invalid++;
+            return -1;
+        }
+        return cache.present(addr) ? -1 : (int)addr;
+    }
+    if(op == "LD" || op == "SD" || op == "SDNT" || op == "LLD" || op == "SCD" || op == "PREF")
+    {
+        //Operando de memoria no formato offset(Rs)
+        unsigned int par = ord[2].find('(');
+        ra_value base = read(ord[2].substr(par+1,ord[2].size()-par-2));
+        unsigned int addr = std::stoi(ord[2].substr(0,par)) + (int)base.value;
+        float value;
+        //PREF: sem destino, so antecipa a linha
+        if(op == "PREF")
+        {
+            if(!base.valid)
+            {
+                invalid++;
+                return -1;
+            }
+            return cache.present(addr) ? -1 : (int)addr;
+        }
+        if(op.at(0) == 'S')
+        {
+            if(base.valid)
+                ra_cache[addr] = read(ord[1]);
+            else
+                invalid++;
+            //Resultado do SCD so existe no commit
+            if(op == "SCD")
+                reg_file[ord[1]] = {false,0};
+            return -1;
+        }
+        if(!base.valid || !mem_read(addr,value))
+        {
+            invalid++;
+            reg_file[ord[1]] = {false,0};
+            return -1;
+        }
+        if(ra_cache.count(addr))
+        {
+            reg_file[ord[1]] = ra_cache[addr];
+            return -1;
+        }
+        if(cache.ready(addr,now))
+        {
+            reg_file[ord[1]] = {true,value};
+            return -1;
+        }
+        //Miss no runahead: o valor fica INV e a linha e buscada antes do load real
+        reg_file[ord[1]] = {false,0};
+        return cache.present(addr) ? -1 : (int)addr;
+    }
+    if(ord.size() < 4)
+        return -1;
+    ra_value a = read(ord[2]);
+    ra_value b = read(ord[3]);
+    ra_value res = {a.valid && b.valid,0};
+    if(!res.valid)
+        invalid++;
+    else if(op.substr(0,4) == "DADD")
+        res.value = a.value + b.value;
+    else if(op.substr(0,4) == "DSUB")
+        res.value = a.value - b.value;
+    else if(op.substr(0,4) == "DMUL")
+        res.value = a.value * b.value;
+    else if(op == "DFMA")
+    {
+        ra_value c = ord.size() > 4 ? read(ord[4]) : ra_value{false,0};
+        if(c.valid)
+            res.value = std::fma(a.value,b.value,c.value);
+        else
+        {
+            invalid++;
+            res.valid = false;
+        }
+    }
+    else if(op == "MOVZ" || op == "MOVN")
+    {
+        //Sem a condicao o destino fica com o valor antigo
+        if((b.value == 0) != (op == "MOVZ"))
+            res = read(ord[1]);
+        else
+            res.value = a.value;
+    }
+    else if(op.substr(0,4) == "DDIV")
+        res.value = b.value ? a.value / b.value : 0;
+    else if(op == "SLT")
+        res.value = a.value < b.value;
+    else if(op == "SGT")
+        res.value = a.value > b.value;
+    else
+    {
+        //Operacao nao modelada: o resultado fica INV, nunca um 0 valido
+        invalid++;
+        res.valid = false;
+    }
+    if(ord[1].at(0) != 'F')
+        res.value = (int)res.value;
+    reg_file[ord[1]] = res;
+    return -1;
+}
+
+void runahead::stop()
+{
+    running = false;
+    ra_cache.clear();
+}
+
+bool runahead::active()
+{
+    return running;
+}
+
+//Registrador do checkpoint ou imediato
+runahead::ra_value runahead::read(string op)
+{
+    if(reg_file.count(op))
+        return reg_file[op];
+    return {true,(float)std::stoi(op)};
+}
+
+bool runahead::mem_read(unsigned int addr, float &value)
+{
+    try
+    {
+        value = std::stof(mem.Get(addr));
+    }
+    catch(...)
+    {
+        return false;
+    }
+    return true;
+}
+
+unsigned int runahead::get_episodes()
+{
+    return episodes;
+}
+
+unsigned int runahead::get_cycles()
+{
+    return cycles;
+}
+
+unsigned int runahead::get_executed()
+{
+    return executed;
+}
+
+unsigned int runahead::get_invalid()
+{
+    return invalid;
+}
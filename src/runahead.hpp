@@ -0,0 +1,58 @@
+#pragma once
+#include<vector>
+#include<map>
+#include<string>
+#include<systemc.h>
+#include<nana/gui/widgets/listbox.hpp>
+#include "grid.hpp"
+#include "data_cache.hpp"
+
+using std::vector;
+using std::map;
+using std::string;
+
+// Execucao em runahead: enquanto um load com miss bloqueia a cabeca do ROB,
+// as instrucoes seguintes a ele sao pre-executadas, uma por ciclo, apenas
+// para descobrir os enderecos dos proximos loads e emitir prefetches.
+// O checkpoint e uma copia do banco de registradores arquitetural (a cabeca
+// bloqueada garante que nada e commitado durante o runahead), com o destino
+// do load marcado como invalido (INV). Valores invalidos se propagam: loads
+// com endereco INV ou cuja linha ainda nao chegou produzem INV, e desvios
+// com operando INV seguem a previsao estatica (para tras tomado, para frente
+// nao tomado). Stores vao para uma cache de runahead que adianta o valor aos
+// loads seguintes. Ao fim do miss o estado do runahead e descartado.
+class runahead
+{
+public:
+    runahead(vector<string> program, nana::listbox &regs, nana::grid &mem, data_cache &cache);
+    // Checkpoint e inicio no PC original seguinte ao load pc, com destino dest INV
+    void start(unsigned int pc, string dest);
+    // Pre-executa uma instrucao; retorna o endereco a buscar por prefetch ou -1
+    int step(sc_time now);
+    // Descarta o estado do runahead
+    void stop();
+    bool active();
+    unsigned int get_episodes();
+    unsigned int get_cycles();
+    unsigned int get_executed();
+    unsigned int get_invalid();
+
+private:
+    struct ra_value
+    {
+        bool valid;
+        float value;
+    };
+    vector<string> program;
+    nana::listbox &regs;
+    nana::grid &mem;
+    data_cache &cache;
+    bool running;
+    unsigned int pc;
+    map<string,ra_value> reg_file; //checkpoint, alterado pela pre-execucao
+    map<unsigned int,ra_value> ra_cache; //stores feitos durante o runahead
+    unsigned int episodes,cycles,executed,invalid;
+
+    ra_value read(string op);
+    bool mem_read(unsigned int addr, float &value);
+};
@@ -1,12 +1,17 @@
 #include "sl_buffer_rob.hpp"
 #include "general.hpp"
 
-sl_buffer_rob::sl_buffer_rob(sc_module_name name,unsigned int t,unsigned int t_outros,map<string,int> instruct_time, nana::listbox &lsbox, nana::listbox::cat_proxy ct, nana::listbox::cat_proxy r_ct): 
+sl_buffer_rob::sl_buffer_rob(sc_module_name name,unsigned int t,unsigned int t_outros,res_pool_rob &p, nana::listbox &lsbox, nana::listbox::cat_proxy ct, nana::listbox::cat_proxy r_ct): 
 sc_module(name),
 tam(t),
 tam_outros(t_outros),
+pool(p),
 table(lsbox)
 {
+    ld_class = pool.add_class(tam_outros,tam_outros+tam);
+    isFlushed = false;
+    issue_tag = 0;
+    smt = NULL;
     string texto;
     ptrs.resize(tam);
     auto cat = table.at(0);
@@ -14,8 +19,7 @@ table(lsbox)
     {
         texto = "Load" + std::to_string(i+1);
         cat.append({std::to_string(cat.size()+1),texto,"False"});
-        ptrs[i] = new res_station_rob(texto.c_str(),i+t_outros,texto,true,instruct_time,cat.at(i+t_outros),ct,r_ct);
-        ptrs[i]->in(in_cdb);
+        ptrs[i] = new res_station_rob(texto.c_str(),i+t_outros,texto,true,pool,i+t_outros,cat.at(i+t_outros),ct,r_ct);
         ptrs[i]->out(out_cdb);
         ptrs[i]->out_mem(out_mem);
     }
@@ -39,6 +43,11 @@ sl_buffer_rob::~sl_buffer_rob()
         delete ptrs[i];
 }
 
+void sl_buffer_rob::set_smt(thread_select *s)
+{
+    smt = s;
+}
+
 void sl_buffer_rob::leitura_issue()
 {
     string p;
@@ -56,27 +65,48 @@ void sl_buffer_rob::leitura_issue()
            ord = {"LD", "R6", "0(R3)", "3", "1", "4"} */
         in_issue->nb_read(p);
         ord = instruction_split(p);
-        cout << "Issue da instrução " << ord[0] << " no ciclo " << sc_time_stamp() << " para " << ptrs[pos]->type_name << endl << flush;
+        issue_tag = std::stoi(ord[ord.size() - 1]);
         pos = busy_check();
-        while(pos == -1)
+        isFlushed = false;
+        if(pos == -1)
+            pool.count_full_stall();
+        while(pos == -1 && !isFlushed)
         {
             cout << "Todas as estacoes ocupadas para a instrucao " << p << " no ciclo " << sc_time_stamp() << endl << flush;
-            wait(out_mem->default_event());
+            //Acorda na liberacao de uma estacao: o pedido a memoria nao libera
+            //a estacao, e esperar por ele perdia a liberacao do mesmo ciclo
+            wait(pool.free_event | flush_event);
             pos = busy_check();
         }
         wait(SC_ZERO_TIME);
         in_issue->notify();
+        //Instrucao descartada pelo flush do ROB enquanto aguardava estacao livre
+        if(isFlushed)
+        {
+            cout << "Instrucao " << p << " descartada pelo flush" << endl << flush;
+            out_issue->write("-1");
+            wait();
+            continue;
+        }
         out_issue->write(std::to_string(pos));
+        if(isFlushed)
+        {
+            wait();
+            continue;
+        }
         cout << "Instrução " << p << " conseguiu espaço para usar uma estação de reserva em " << sc_time_stamp() << endl << flush;
         // Anteriormente era ord[4]
         // Acréscimo devido à informação adicional (pc_original_instruction)
         // Feita em instruction_queue_rob.cpp
         rob_pos = std::stoi(ord[ord.size() - 1]); // Pode ser ord[5], last position
-        ptrs[pos]->op = ord[0];
-        ptrs[pos]->instr_pos = std::stoi(ord[3]);
+        pool.op[pos+tam_outros] = ord[0];
+        pool.instr_pos[pos+tam_outros] = std::stoi(ord[3]);
+        pool.pc[pos+tam_outros] = std::stoi(ord[ord.size() - 2]);
         cat.at(pos+tam_outros).text(OP,ord[0]);
-        ptrs[pos]->dest = rob_pos;
-        ptrs[pos]->Busy = true;
+        pool.dest[pos+tam_outros] = rob_pos;
+        if(ord[0] == "LD" || ord[0] == "LLD" || ord[0] == "LV")
+            pool.set_producer(ord[1],rob_pos);
+        pool.set_busy(pos+tam_outros,true);
         cat.at(pos+tam_outros).text(BUSY,"True");
         cout << "Instrucao " << ord[0] << " aguardando o calculo de endereço" << endl << flush;
         wait();
@@ -96,15 +126,19 @@ void sl_buffer_rob::add_rec()
         addr = std::stoul(ord[1]);
         for(unsigned int i = 0 ; i < tam ; i++)
         {
-            if(ptrs[i]->dest == rob_pos && ptrs[i]->isFlushed == false)
+            if(pool.is_busy(i+tam_outros) && pool.dest[i+tam_outros] == rob_pos && ptrs[i]->isFlushed == false)
             {
-                cout << "Instrucao " << ptrs[i]->op << " concluiu o calculo do endereco no ciclo " << sc_time_stamp() << endl << flush;
-                ptrs[i]->a = addr;
+                cout << "Instrucao " << pool.op[i+tam_outros] << " concluiu o calculo do endereco no ciclo " << sc_time_stamp() << endl << flush;
+                pool.a[i+tam_outros] = addr;
                 cat.at(i+tam_outros).text(A,std::to_string(addr));
                 cat.at(i+tam_outros).text(VK,"");
-                chk = check_conflict(rob_pos,addr);
+                //PREF nao le dado: nao espera os stores anteriores
+                chk = pool.op[i+tam_outros] == "PREF" ? 0 : check_conflict(rob_pos,addr);
                 if(!chk)
+                {
+                    pool.set_ready(i+tam_outros,true);
                     ptrs[i]->exec_event.notify(1,SC_NS);
+                }
                 else
                     addr_dep[chk].push_back(i);
                 break;
@@ -123,7 +157,10 @@ void sl_buffer_rob::leitura_mem()
     if(check_find(rob_pos))
     {
         for(unsigned int i = 0 ; i < addr_dep[rob_pos].size() ; i++)
+        {
+            pool.set_ready(addr_dep[rob_pos][i]+tam_outros,true);
             ptrs[addr_dep[rob_pos][i]]->exec_event.notify(1,SC_NS);
+        }
         addr_dep.erase(rob_pos);
     }
 }
@@ -134,23 +171,53 @@ void sl_buffer_rob::leitura_rob()
     while(true)
     {
         in_rob->nb_read(p);
-        if(p == "F")
+        if(is_flush(p))
         {
             in_rob->notify();
-            addr_dep.clear();
+            pool.flush_gen++;
+            //Loads descartados deixam de esperar stores; stores descartados nao liberam ninguem
+            for(auto it = addr_dep.begin() ; it != addr_dep.end() ; )
+            {
+                vector<unsigned int> &dep = it->second;
+                for(unsigned int k = 0 ; k < dep.size() ; )
+                {
+                    if(flush_hits(p,pool.dest[dep[k]+tam_outros]))
+                        dep.erase(dep.begin() + k);
+                    else
+                        k++;
+                }
+                if(dep.empty() || flush_hits(p,it->first))
+                    it = addr_dep.erase(it);
+                else
+                    it++;
+            }
             for(unsigned int i = 0 ; i < ptrs.size() ; i++)
             {
                 auto table_item = cat.at(i+tam_outros);
-                if(ptrs[i]->Busy)
+                if(pool.is_busy(i+tam_outros) && flush_hits(p,pool.dest[i+tam_outros]))
                 {
+                    //Acesso a memoria em andamento: a estacao se libera no fim
+                    //dele; liberada aqui, o issue do mesmo ciclo poderia ocupa-la
+                    //e perde-la para esse fim
+                    if(ptrs[i]->running)
+                    {
+                        ptrs[i]->isFlushed = true;
+                        ptrs[i]->isFlushed_event.notify();
+                        continue;
+                    }
                     ptrs[i]->isFlushed = false;
-                    ptrs[i]->Busy = false;
+                    ptrs[i]->exec_event.cancel(); //Load com endereco recem calculado nao chega a executar
+                    pool.set_busy(i+tam_outros,false);
                     table_item.text(BUSY,"False");
                     for(unsigned int k = 3 ; k < table_item.columns() ; k++)
                         table_item.text(k,"");
-                    //ptrs[i]->isFlushed_event.notify();
                 }
             }
+            if(flush_hits(p,issue_tag))
+                isFlushed = true;
+            //No SMT o flush de uma thread pode liberar o buffer que o issue da
+            //outra aguarda; acorda o issue sempre, senao ele fica preso
+            flush_event.notify();
         }
         wait();
     }
@@ -158,10 +225,10 @@ void sl_buffer_rob::leitura_rob()
 
 int sl_buffer_rob::busy_check()
 {
-    for(unsigned int i = 0 ; i < tam ; i++)
-        if(ptrs[i]->Busy == false)
-            return i;
-    return -1;
+    int pos = pool.find_free(ld_class);
+    if(pos == -1)
+        return -1;
+    return pos-tam_outros;
 }
 
 int sl_buffer_rob::check_conflict(unsigned int rob_pos, unsigned int addr)
@@ -1,6 +1,8 @@
 #pragma once
 #include "interfaces.hpp"
 #include "res_station_rob.hpp"
+#include "res_pool_rob.hpp"
+#include "thread_select.hpp"
 #include<vector>
 #include<deque>
 #include<map>
@@ -18,22 +20,29 @@ public:
     sc_port<read_if> in_mem;
     sc_port<write_if> out_mem;
     sc_port<read_if> in_cdb;
-    sc_port<write_if> out_cdb;
+    sc_port<prio_write_if> out_cdb;
     sc_port<read_if> in_adu;
     sc_port<write_if_f> out_rob;
     sc_port<read_if_f> in_rob;
 
     SC_HAS_PROCESS(sl_buffer_rob);
 
-    sl_buffer_rob(sc_module_name name,unsigned int t,unsigned int t_outros,map<string,int> instruct_time, nana::listbox &lsbox, nana::listbox::cat_proxy ct, nana::listbox::cat_proxy r_ct);
+    sl_buffer_rob(sc_module_name name,unsigned int t,unsigned int t_outros,res_pool_rob &p, nana::listbox &lsbox, nana::listbox::cat_proxy ct, nana::listbox::cat_proxy r_ct);
     ~sl_buffer_rob();
     void leitura_issue();
     void add_rec();
     void leitura_mem();
     void leitura_rob();
+    void set_smt(thread_select *s);
 private:
     unsigned int tam;
     unsigned int tam_outros;
+    unsigned int ld_class; //classe das estacoes de load no res_pool_rob
+    res_pool_rob &pool;
+    bool isFlushed; //flush ocorreu enquanto o issue aguardava estacao livre
+    unsigned int issue_tag; //entrada do ROB da instrucao em issue
+    sc_event flush_event;
+    thread_select *smt;
     vector<res_station_rob *>ptrs;
     nana::listbox &table;
     map<unsigned int,vector<unsigned int> >addr_dep;
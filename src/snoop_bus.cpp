@@ -0,0 +1,81 @@
+#include "snoop_bus.hpp"
+#include "data_cache.hpp"
+
+snoop_bus::snoop_bus(unsigned int latency):
+latency(latency ? latency : 1),
+busy_until(SC_ZERO_TIME)
+{
+    for(unsigned int i = 0 ; i < 4 ; i++)
+        count[i] = 0;
+    transfers = busy_cycles = wait_cycles = 0;
+}
+
+unsigned int snoop_bus::attach(data_cache *cache)
+{
+    caches.push_back(cache);
+    return caches.size() - 1;
+}
+
+sc_time snoop_bus::transaction(unsigned int core, int type, unsigned int block, sc_time now, bool &shared)
+{
+    sc_time start = busy_until > now ? busy_until : now;
+    wait_cycles += (start - now).value() / 1000;
+    busy_until = start + sc_time(latency,SC_NS);
+    busy_cycles += latency;
+    count[type]++;
+    shared = false;
+    if(type != BUS_WB)
+    {
+        for(unsigned int c = 0 ; c < caches.size() ; c++)
+            if(c != core && caches[c]->snoop(type,block))
+                shared = true;
+        if(shared && type != BUS_UPGR)
+            transfers++;
+    }
+    return busy_until;
+}
+
+string snoop_bus::type_name(int type)
+{
+    switch(type)
+    {
+        case BUS_RD:
+            return "BusRd";
+        case BUS_RDX:
+            return "BusRdX";
+        case BUS_UPGR:
+            return "BusUpgr";
+        default:
+            return "Writeback";
+    }
+}
+
+unsigned int snoop_bus::get_latency()
+{
+    return latency;
+}
+
+unsigned int snoop_bus::get_count(int type)
+{
+    return count[type];
+}
+
+unsigned int snoop_bus::get_transactions()
+{
+    return count[BUS_RD] + count[BUS_RDX] + count[BUS_UPGR] + count[BUS_WB];
+}
+
+unsigned int snoop_bus::get_transfers()
+{
+    return transfers;
+}
+
+unsigned int snoop_bus::get_busy_cycles()
+{
+    return busy_cycles;
+}
+
+unsigned int snoop_bus::get_wait_cycles()
+{
+    return wait_cycles;
+}
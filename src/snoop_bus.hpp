@@ -0,0 +1,45 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<systemc.h>
+
+using std::vector;
+using std::string;
+
+class data_cache;
+
+// Barramento compartilhado que liga as caches de dados privadas dos nucleos
+// a memoria no modo multicore. Cada miss ou escrita em linha compartilhada
+// vira uma transacao, e as outras caches observam (snooping) o barramento e
+// mudam o estado MESI da sua copia: BusRd rebaixa M e E para S (M devolve o
+// bloco a memoria), BusRdX e BusUpgr invalidam as copias. Uma transacao ocupa
+// o barramento por latency ciclos e as seguintes esperam (barramento atomico);
+// a latencia da memoria nao o ocupa. Um bloco presente em outra cache chega
+// por transferencia entre caches, ao fim da transacao.
+class snoop_bus
+{
+public:
+    enum { BUS_RD, BUS_RDX, BUS_UPGR, BUS_WB };
+
+    snoop_bus(unsigned int latency = 2);
+    // Conecta a cache de um nucleo; retorna o numero do nucleo
+    unsigned int attach(data_cache *cache);
+    // Transacao type do nucleo core para o bloco, pedida em now. Retorna o
+    // instante em que ela termina; shared indica copia em outra cache
+    sc_time transaction(unsigned int core, int type, unsigned int block, sc_time now, bool &shared);
+    static string type_name(int type);
+    unsigned int get_latency();
+    unsigned int get_count(int type);
+    unsigned int get_transactions();
+    unsigned int get_transfers();
+    unsigned int get_busy_cycles();
+    unsigned int get_wait_cycles();
+
+private:
+    vector<data_cache*> caches;
+    unsigned int latency;
+    sc_time busy_until; //fim da ultima transacao concedida
+    unsigned int count[4];
+    unsigned int transfers; //blocos vindos de outra cache
+    unsigned int busy_cycles,wait_cycles;
+};
@@ -0,0 +1,182 @@
+#include "thread_select.hpp"
+#include<cctype>
+
+thread_select::thread_select(unsigned int threads, unsigned int partition, int policy):
+threads(threads),
+partition(partition),
+policy(policy),
+req_stamp(threads,SC_ZERO_TIME),
+requested(threads,false),
+done(threads,false),
+occupancy(threads,0),
+fetched(threads,0),
+committed(threads,0),
+finish(threads,SC_ZERO_TIME)
+{
+    owner = chosen = -1;
+    last = threads-1;
+    stamp = SC_ZERO_TIME;
+    decided = false;
+}
+
+unsigned int thread_select::get_threads()
+{
+    return threads;
+}
+
+unsigned int thread_select::get_partition()
+{
+    return partition;
+}
+
+int thread_select::get_policy()
+{
+    return policy;
+}
+
+string thread_select::policy_name(int policy)
+{
+    if(policy == SMT_ICOUNT)
+        return "ICOUNT";
+    return "Rodizio";
+}
+
+unsigned int thread_select::entry_thread(unsigned int entry)
+{
+    return (entry-1)/partition;
+}
+
+unsigned int thread_select::instr_thread(unsigned int gpc)
+{
+    return gpc % threads;
+}
+
+unsigned int thread_select::first_entry(unsigned int t)
+{
+    return t*partition + 1;
+}
+
+unsigned int thread_select::last_entry(unsigned int t)
+{
+    return (t+1)*partition;
+}
+
+string thread_select::rename(string inst, unsigned int t, unsigned int mem_offset)
+{
+    size_t sp = inst.find(' ');
+    if(sp == string::npos)
+        return inst;
+    string op = inst.substr(0,sp);
+    string res = op;
+    size_t i = sp;
+    while(i < inst.size())
+    {
+        char c = inst[i];
+        char prev = inst[i-1];
+        if((c == 'R' || c == 'F' || c == 'V') && i+1 < inst.size() && isdigit(inst[i+1]) && (prev == ' ' || prev == ',' || prev == '('))
+        {
+            size_t j = i+1;
+            while(j < inst.size() && isdigit(inst[j]))
+                j++;
+            res += c + std::to_string(std::stoi(inst.substr(i+1,j-i-1)) + 32*t);
+            i = j;
+        }
+        else
+        {
+            res += c;
+            i++;
+        }
+    }
+    //Deslocamento do operando de memoria "off(Rk)"
+    size_t par = res.find('(');
+    if((op == "LD" || op == "SD" || op == "SDNT" || op == "PREF" || op == "LLD" || op == "SCD" || op == "LV" || op == "SV") && mem_offset && par != string::npos)
+    {
+        size_t start = res.find_last_of(" ,",par) + 1;
+        int off = start < par ? std::stoi(res.substr(start,par-start)) : 0;
+        res = res.substr(0,start) + std::to_string(off + (int)mem_offset) + res.substr(par);
+    }
+    return res;
+}
+
+void thread_select::request(unsigned int t)
+{
+    req_stamp[t] = sc_time_stamp();
+    requested[t] = true;
+}
+
+//Escolhe a thread do ciclo entre as que pediram e tem espaco no ROB
+void thread_select::decide()
+{
+    chosen = -1;
+    for(unsigned int k = 1 ; k <= threads ; k++)
+    {
+        unsigned int t = (last+k) % threads;
+        if(!requested[t] || req_stamp[t] != sc_time_stamp() || occupancy[t] >= partition)
+            continue;
+        if(chosen == -1 || (policy == SMT_ICOUNT && occupancy[t] < occupancy[chosen]))
+            chosen = t;
+    }
+}
+
+bool thread_select::grant(unsigned int t)
+{
+    if(owner >= 0)
+        return owner == (int)t;
+    if(!decided || stamp != sc_time_stamp())
+    {
+        stamp = sc_time_stamp();
+        decided = true;
+        decide();
+    }
+    if(chosen != (int)t)
+        return false;
+    owner = t;
+    last = t;
+    fetched[t]++;
+    return true;
+}
+
+void thread_select::release(unsigned int t)
+{
+    if(owner == (int)t)
+        owner = -1;
+}
+
+void thread_select::set_done(unsigned int t, bool d)
+{
+    done[t] = d;
+}
+
+bool thread_select::all_done()
+{
+    for(unsigned int t = 0 ; t < threads ; t++)
+        if(!done[t])
+            return false;
+    return true;
+}
+
+void thread_select::set_occupancy(unsigned int t, unsigned int n)
+{
+    occupancy[t] = n;
+}
+
+void thread_select::commit(unsigned int t)
+{
+    committed[t]++;
+    finish[t] = sc_time_stamp();
+}
+
+unsigned int thread_select::get_fetched(unsigned int t)
+{
+    return fetched[t];
+}
+
+unsigned int thread_select::get_committed(unsigned int t)
+{
+    return committed[t];
+}
+
+unsigned int thread_select::get_finish(unsigned int t)
+{
+    return finish[t].value() / 1000;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include<vector>
+#include<string>
+#include<systemc.h>
+
+using std::vector;
+using std::string;
+
+// Multithreading simultaneo (SMT): as threads compartilham a busca, as
+// estacoes de reserva, as unidades funcionais, o CDB e a memoria. Cada uma
+// tem a sua fila de instrucoes, os seus registradores (R, F e V renomeados
+// para R32*t.., F32*t.. e V32*t..) e uma particao do ROB com as entradas t*part+1..(t+1)*part.
+// A busca envia uma instrucao por ciclo, e a cada ciclo este arbitro escolhe
+// a thread: rodizio (round-robin) ou ICOUNT, a thread com menos instrucoes no
+// ROB. Threads com a particao cheia ou sem instrucoes ficam de fora.
+// Na fila de instrucoes da interface a instrucao i da thread t fica na linha
+// i*threads + t, que e o pc geral enviado com a instrucao.
+class thread_select
+{
+public:
+    enum { SMT_ROUND_ROBIN, SMT_ICOUNT };
+
+    thread_select(unsigned int threads, unsigned int partition, int policy);
+    unsigned int get_threads();
+    unsigned int get_partition();
+    int get_policy();
+    static string policy_name(int policy);
+    // Thread dona da entrada entry do ROB (1..threads*partition)
+    unsigned int entry_thread(unsigned int entry);
+    // Thread da instrucao na linha gpc da fila da interface
+    unsigned int instr_thread(unsigned int gpc);
+    // Primeira e ultima entradas do ROB da thread t
+    unsigned int first_entry(unsigned int t);
+    unsigned int last_entry(unsigned int t);
+    // Renomeia os registradores da instrucao para os da thread t e desloca
+    // os enderecos de LD/SD (e LLD/SCD, LV/SV, PREF/SDNT) em mem_offset palavras
+    static string rename(string inst, unsigned int t, unsigned int mem_offset);
+
+    // Fila da thread t tem instrucao para enviar neste ciclo
+    void request(unsigned int t);
+    // Thread t pode enviar neste ciclo; a busca fica com ela ate release
+    bool grant(unsigned int t);
+    void release(unsigned int t);
+    // Fila da thread t chegou ao fim do programa
+    void set_done(unsigned int t, bool done);
+    bool all_done();
+    // Instrucoes da thread t no ROB (atualizado pelo ROB)
+    void set_occupancy(unsigned int t, unsigned int n);
+    void commit(unsigned int t);
+
+    unsigned int get_fetched(unsigned int t);
+    unsigned int get_committed(unsigned int t);
+    unsigned int get_finish(unsigned int t);
+
+private:
+    unsigned int threads,partition;
+    int policy;
+    int owner; //thread enviando uma instrucao, -1 se nenhuma
+    int chosen; //thread escolhida no ciclo de stamp
+    unsigned int last; //ultima thread atendida
+    sc_time stamp;
+    bool decided; //stamp valido: ja houve uma escolha
+    vector<sc_time> req_stamp;
+    vector<bool> requested; //req_stamp valido: a thread ja pediu a busca
+    vector<bool> done;
+    vector<unsigned int> occupancy;
+    vector<unsigned int> fetched,committed;
+    vector<sc_time> finish; //instante do ultimo commit da thread
+
+    void decide();
+};
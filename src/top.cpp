@@ -1,6 +1,11 @@
 #include "top.hpp"
+#include<algorithm>
 
-top::top(sc_module_name name): sc_module(name){}
+top::top(sc_module_name name): sc_module(name)
+{
+    core_id = 0;
+    shared_bus = NULL;
+}
 
 void top::simple_mode(unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time,vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr_gui, nana::label &ccount)
 {
@@ -15,6 +20,7 @@ void top::simple_mode(unsigned int nadd, unsigned int nmul,unsigned int nload,ma
     iss_ctrl = unique_ptr<issue_control>(new issue_control("issue_control"));
     clk = unique_ptr<clock_>(new clock_("clock",1,ccount));
     fila = unique_ptr<instruction_queue>(new instruction_queue("fila_inst",instruct_queue,instr_gui));
+    fila->set_regs(&regs);
     rs_ctrl = unique_ptr<res_vector>(new res_vector("rs_control",nadd,nmul,instruct_time,table,instr_gui.at(0)));
     rb = unique_ptr<register_bank>(new register_bank("register_bank", regs));
     slb = unique_ptr<sl_buffer>(new sl_buffer("sl_buffer_control",nload,nadd+nmul,instruct_time,table,instr_gui.at(0)));
@@ -51,35 +57,122 @@ void top::simple_mode(unsigned int nadd, unsigned int nmul,unsigned int nload,ma
     mem->out(*CDB);
 }
 
-void top::rob_mode(int n_bits, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr_gui, nana::label &ccount, nana::listbox &rob_gui)
+void top::rob_mode(int n_bits, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, map<string,int> config, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr_gui, nana::label &ccount, nana::listbox &rob_gui)
 {
-    int rob_size = 10; //Tamanho do REORDER BUFFER
-    CDB = unique_ptr<bus>(new bus("CDB"));
-    mem_bus = unique_ptr<bus>(new bus("mem_bus"));
-    clock_bus = unique_ptr<bus>(new bus("clock_bus"));
-    adu_bus = unique_ptr<bus>(new bus("adu_bus"));
-    adu_sl_bus = unique_ptr<bus>(new bus("adu_sl_bus"));
-    mem_slb_bus = unique_ptr<bus>(new bus("mem_slb_bus"));
-    iq_rob_bus = unique_ptr<bus>(new bus("iq_rob_bus"));
-    rob_statval_bus = unique_ptr<cons_bus_fast>(new cons_bus_fast("rob_statval_bus"));//Este canal se comunida com rs_ctrl_r e com adu
-    rob_adu_bus = unique_ptr<cons_bus>(new cons_bus("rob_adu_bus")); //usado para flush
-    inst_bus = unique_ptr<cons_bus>(new cons_bus("inst_bus"));
-    rst_bus = unique_ptr<cons_bus>(new cons_bus("rst_bus"));
-    sl_bus = unique_ptr<cons_bus>(new cons_bus("sl_bus"));
-    rob_bus = unique_ptr<cons_bus>(new cons_bus("rob_bus"));
-    ad_bus = unique_ptr<cons_bus>(new cons_bus("ad_bus"));
-    rob_slb_bus = unique_ptr<cons_bus_fast>(new cons_bus_fast("rob_slb_bus"));
-    rb_bus = unique_ptr<cons_bus_fast>(new cons_bus_fast("rb_bus"));
+    rob_build(n_bits,0,1,nadd,nmul,nload,instruct_time,config,instruct_queue,table,mem_gui,regs,instr_gui,ccount,rob_gui);
+}
 
-    clk = unique_ptr<clock_>(new clock_("clock",1,ccount));
-    iss_ctrl_r = unique_ptr<issue_control_rob>(new issue_control_rob("issue_control_rob"));
-    fila_r = unique_ptr<instruction_queue_rob>(new instruction_queue_rob("fila_inst_rob",instruct_queue,rob_size,instr_gui));
-    rob = unique_ptr<reorder_buffer>(new reorder_buffer("rob",rob_size,n_bits, 0, 1, rob_gui,instr_gui.at(0)));
-    adu = unique_ptr<address_unit>(new address_unit("address_unit",instruct_time["MEM"],instr_gui.at(0),table.at(0),nadd+nmul));
-    rs_ctrl_r = unique_ptr<res_vector_rob>(new res_vector_rob("rs_vc",nadd,nmul,instruct_time,table,instr_gui.at(0),rob_gui.at(0)));
-    rb_r = unique_ptr<register_bank_rob>(new register_bank_rob("register_bank_rob",regs));
-    slb_r = unique_ptr<sl_buffer_rob>(new sl_buffer_rob("sl_buffer_rob",nload,nadd+nmul,instruct_time,table,instr_gui.at(0),rob_gui.at(0)));
-    mem_r = unique_ptr<memory_rob>(new memory_rob("memory_rob", mem_gui));
+void top::rob_mode_bpb(int n_bits, int bpb_size, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, map<string,int> config, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr_gui, nana::label &ccount, nana::listbox &rob_gui)
+{
+    rob_build(n_bits,bpb_size,2,nadd,nmul,nload,instruct_time,config,instruct_queue,table,mem_gui,regs,instr_gui,ccount,rob_gui);
+}
+
+// Monta o modo com especulacao; bpb_mode 1 usa o preditor de n bits e 2 o BPB
+void top::rob_build(int n_bits, int bpb_size, int bpb_mode, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, map<string,int> config, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr_gui, nana::label &ccount, nana::listbox &rob_gui)
+{
+    //Tamanho do REORDER BUFFER (de cada thread no SMT)
+    int rob_size = config["ROB_SIZE"] > 0 ? config["ROB_SIZE"] : 10;
+    // Multicore: nucleos independentes, sem SMT, com cache L1 privada coerente
+    unsigned int ncores = config["CORES"];
+    unsigned int threads = config["SMT_THREADS"] > 1 && !ncores ? config["SMT_THREADS"] : 1;
+    vector<vector<string>> programs(1,instruct_queue);
+    if(threads > 1)
+        programs = smt_programs(threads,config["SMT_MEM_STRIDE"],instruct_queue,mem_gui,regs,instr_gui);
+    // Janela unificada: cada classe pode ocupar qualquer uma das window entradas,
+    // entao cada grupo recebe window estacoes e o pool limita o total ocupado
+    unsigned int window = 0;
+    if(config["RS_UNIFIED"])
+    {
+        window = config["RS_TOTAL"] > 0 ? config["RS_TOTAL"] : nadd+nmul+nload;
+        nadd = nmul = nload = window;
+    }
+    CDB = unique_ptr<bus>(new bus(unit_name("CDB").c_str()));
+    mem_bus = unique_ptr<bus>(new bus(unit_name("mem_bus").c_str()));
+    clock_bus = unique_ptr<bus>(new bus(unit_name("clock_bus").c_str()));
+    adu_bus = unique_ptr<bus>(new bus(unit_name("adu_bus").c_str()));
+    adu_sl_bus = unique_ptr<bus>(new bus(unit_name("adu_sl_bus").c_str()));
+    mem_slb_bus = unique_ptr<bus>(new bus(unit_name("mem_slb_bus").c_str()));
+    iq_rob_bus = unique_ptr<bus>(new bus(unit_name("iq_rob_bus").c_str()));
+    rob_statval_bus = unique_ptr<cons_bus_fast>(new cons_bus_fast(unit_name("rob_statval_bus").c_str()));//Este canal se comunida com rs_ctrl_r e com adu
+    rob_adu_bus = unique_ptr<cons_bus>(new cons_bus(unit_name("rob_adu_bus").c_str())); //usado para flush
+    inst_bus = unique_ptr<cons_bus>(new cons_bus(unit_name("inst_bus").c_str()));
+    rst_bus = unique_ptr<cons_bus>(new cons_bus(unit_name("rst_bus").c_str()));
+    sl_bus = unique_ptr<cons_bus>(new cons_bus(unit_name("sl_bus").c_str()));
+    rob_bus = unique_ptr<cons_bus>(new cons_bus(unit_name("rob_bus").c_str()));
+    ad_bus = unique_ptr<cons_bus>(new cons_bus(unit_name("ad_bus").c_str()));
+    rob_slb_bus = unique_ptr<cons_bus_fast>(new cons_bus_fast(unit_name("rob_slb_bus").c_str()));
+    rb_bus = unique_ptr<cons_bus_fast>(new cons_bus_fast(unit_name("rb_bus").c_str()));
+
+    clk = unique_ptr<clock_>(new clock_(unit_name("clock").c_str(),1,ccount));
+    iss_ctrl_r = unique_ptr<issue_control_rob>(new issue_control_rob(unit_name("issue_control_rob").c_str()));
+    fila_r = unique_ptr<instruction_queue_rob>(new instruction_queue_rob(unit_name("fila_inst_rob").c_str(),programs[0],rob_size*threads,instr_gui));
+    rob = unique_ptr<reorder_buffer>(new reorder_buffer(unit_name("rob").c_str(),rob_size*threads, n_bits, bpb_size, bpb_mode, rob_gui,instr_gui.at(0)));
+    adu = unique_ptr<address_unit>(new address_unit(unit_name("address_unit").c_str(),instruct_time["MEM"],instr_gui.at(0),table.at(0),nadd+nmul));
+    // Preditor de criticidade com 64 entradas se CRIT_SIZE nao for informado
+    unsigned int crit_size = config["CRIT_SIZE"] > 0 ? config["CRIT_SIZE"] : 64;
+    pool = unique_ptr<res_pool_rob>(new res_pool_rob(nadd+nmul+nload,instruct_time,config["SELECT_POLICY"],crit_size));
+    CDB->set_arbitration(config["CRIT_CDB"]);
+    pool->set_rob_waiting([this](unsigned int tag){ return rob->get_waiting(tag); });
+    // Unidades funcionais compartilhadas, na ordem das classes de res_vector_rob (add, mult)
+    pool->add_fu(config["FU_ADD"]);
+    pool->add_fu(config["FU_MUL"]);
+    rs_ctrl_r = unique_ptr<res_vector_rob>(new res_vector_rob(unit_name("rs_vc").c_str(),nadd,nmul,*pool,table,instr_gui.at(0),rob_gui.at(0)));
+    // DFMA em unidades proprias se FU_FMA for informado; senao usa as unidades MUL
+    if(config["FU_FMA"] > 0)
+        rs_ctrl_r->set_fma_fu(pool->add_fu(config["FU_FMA"]));
+    // Instrucoes vetoriais: 4 elementos por registrador V, processados de uma
+    // vez em uma unidade vetorial, se VLEN, VWIDTH e FU_VEC nao forem informados
+    rs_ctrl_r->set_vec_fu(pool->add_fu(config["FU_VEC"] > 0 ? config["FU_VEC"] : 1));
+    pool->set_vector(config["VLEN"],config["VWIDTH"]);
+    rob->set_vlen(pool->get_vlen());
+    rb_r = unique_ptr<register_bank_rob>(new register_bank_rob(unit_name("register_bank_rob").c_str(),regs));
+    slb_r = unique_ptr<sl_buffer_rob>(new sl_buffer_rob(unit_name("sl_buffer_rob").c_str(),nload,nadd+nmul,*pool,table,instr_gui.at(0),rob_gui.at(0)));
+    // Classes criadas por res_vector_rob (add, mult) e sl_buffer_rob (load/store)
+    pool->set_window(window);
+    pool->set_class_limit(0,config["RS_LIMIT_ADD"]);
+    pool->set_class_limit(1,config["RS_LIMIT_MUL"]);
+    pool->set_class_limit(2,config["RS_LIMIT_LOAD"]);
+    pool->set_bypass(config["BYPASS_LATENCY"],config["BYPASS_PARTIAL"],config["BYPASS_MISS"] > 0 ? config["BYPASS_MISS"] : 2);
+    // Clusters com as estacoes add e mult; 1 ciclo entre clusters se CLUSTER_DELAY nao for informado
+    pool->set_clusters(config["CLUSTERS"],config["CLUSTER_DELAY"] > 0 ? config["CLUSTER_DELAY"] : 1,config["CLUSTER_STEER"],{0,1});
+    rb_r->set_ports(config["RF_READ_PORTS"],config["RF_WRITE_PORTS"]);
+    fila_r->set_fusion(config["FUSION"]);
+    // FTQ com blocos de ate 4 instrucoes se FTQ_BLOCK nao for informado
+    unsigned int ftq_block = config["FTQ_BLOCK"] > 0 ? config["FTQ_BLOCK"] : 4;
+    auto ftq_predict = [this](unsigned int pc){ return rob->peek_prediction(pc); };
+    fila_r->set_ftq(config["FTQ_SIZE"],ftq_block,ftq_predict);
+    if(config["FTQ_SIZE"])
+        rob->set_fetch_prediction([this](unsigned int t, unsigned int gpc){
+            return (t ? fila_smt[t-1] : fila_r)->fetch_prediction(gpc); });
+    fila_r->set_uop_cache(config["UOP_CACHE"],config["LSD_SIZE"],config["DECODE_LATENCY"]);
+    fila_r->set_regs(&regs);
+    rob->set_move_elim(config["MOVE_ELIM"]);
+    // Preditor de valor com 64 entradas e limiar de confianca 2 se nao informados
+    rob->set_value_pred(config["VALUE_PRED"],config["VP_SIZE"] > 0 ? config["VP_SIZE"] : 64,config["VP_CONF"] > 0 ? config["VP_CONF"] : 2);
+    mem_r = unique_ptr<memory_rob>(new memory_rob(unit_name("memory_rob").c_str(), mem_gui));
+    // Sem DCACHE_LINES a cache fica desligada e os loads nao tem latencia extra
+    // (no multicore a L1 tem 16 linhas); blocos de 4 palavras e miss de 20
+    // ciclos se nao informados
+    unsigned int lines = config["DCACHE_LINES"] > 0 || !ncores ? config["DCACHE_LINES"] : 16;
+    dcache = unique_ptr<data_cache>(new data_cache(lines,config["DCACHE_BLOCK"] > 0 ? config["DCACHE_BLOCK"] : 4,config["MISS_LATENCY"] > 0 ? config["MISS_LATENCY"] : 20));
+    mem_r->set_cache(dcache.get());
+    mem_r->set_vlen(pool->get_vlen());
+    if(ncores)
+    {
+        // Barramento de 2 ciclos por transacao se BUS_LATENCY nao for informado
+        if(!core_id)
+        {
+            snoop = unique_ptr<snoop_bus>(new snoop_bus(config["BUS_LATENCY"] > 0 ? config["BUS_LATENCY"] : 2));
+            shared_bus = snoop.get();
+        }
+        dcache->set_coherence(shared_bus);
+    }
+    rob->set_mem_flush(dcache->enabled());
+    if(config["RUNAHEAD"] > 0 && threads == 1)
+    {
+        ra = unique_ptr<runahead>(new runahead(instruct_queue,regs,mem_gui,*dcache));
+        rob->set_runahead(ra.get(),config["RUNAHEAD"]);
+    }
 
     clk->out(*clock_bus);
 
@@ -87,6 +180,30 @@ void top::rob_mode(int n_bits, unsigned int nadd, unsigned int nmul,unsigned int
     fila_r->out(*inst_bus);
     fila_r->in_rob(*iq_rob_bus);
 
+    // SMT: uma fila por thread, todas no mesmo barramento de issue
+    if(threads > 1)
+    {
+        smt = unique_ptr<thread_select>(new thread_select(threads,rob_size,config["SMT_POLICY"]));
+        fila_r->set_smt(smt.get(),0);
+        for(unsigned int t = 1 ; t < threads ; t++)
+        {
+            string name = "fila_inst_rob_" + std::to_string(t);
+            fila_smt.push_back(unique_ptr<instruction_queue_rob>(new instruction_queue_rob(unit_name(name).c_str(),programs[t],rob_size*threads,instr_gui)));
+            fila_smt.back()->set_fusion(config["FUSION"]);
+            fila_smt.back()->set_ftq(config["FTQ_SIZE"],ftq_block,ftq_predict);
+            fila_smt.back()->set_uop_cache(config["UOP_CACHE"],config["LSD_SIZE"],config["DECODE_LATENCY"]);
+            fila_smt.back()->set_regs(&regs);
+            fila_smt.back()->set_smt(smt.get(),t);
+            fila_smt.back()->in(*clock_bus);
+            fila_smt.back()->out(*inst_bus);
+            fila_smt.back()->in_rob(*iq_rob_bus);
+        }
+        rob->set_smt(smt.get());
+        iss_ctrl_r->set_smt(smt.get());
+        mem_r->set_smt(smt.get());
+        slb_r->set_smt(smt.get());
+    }
+
     iss_ctrl_r->in(*inst_bus);
     iss_ctrl_r->out_rsv(*rst_bus);
     iss_ctrl_r->out_slbuff(*sl_bus);
@@ -94,6 +211,7 @@ void top::rob_mode(int n_bits, unsigned int nadd, unsigned int nmul,unsigned int
     iss_ctrl_r->in_rob(*rob_bus);
     iss_ctrl_r->out_rob(*rob_bus);
     iss_ctrl_r->out_adu(*ad_bus);
+    iss_ctrl_r->in_iq(*iq_rob_bus);
 
     rob->in_issue(*rob_bus);
     rob->out_issue(*rob_bus);
@@ -144,101 +262,115 @@ void top::rob_mode(int n_bits, unsigned int nadd, unsigned int nmul,unsigned int
     mem_r->in(*mem_bus);
     mem_r->out(*CDB);
     mem_r->out_slb(*mem_slb_bus);
+
+    if(ncores > 1 && !core_id)
+        build_cores(n_bits,bpb_size,bpb_mode,nadd,nmul,nload,instruct_time,config,instruct_queue,mem_gui,regs);
 }
 
-void top::rob_mode_bpb(int n_bits, int bpb_size, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr_gui, nana::label &ccount, nana::listbox &rob_gui)
+//Nome de um modulo: os nucleos 1.. acrescentam o seu numero aos nomes do nucleo 0
+string top::unit_name(string name)
 {
-    int rob_size = 10; //Tamanho do REORDER BUFFER
-    CDB = unique_ptr<bus>(new bus("CDB"));
-    mem_bus = unique_ptr<bus>(new bus("mem_bus"));
-    clock_bus = unique_ptr<bus>(new bus("clock_bus"));
-    adu_bus = unique_ptr<bus>(new bus("adu_bus"));
-    adu_sl_bus = unique_ptr<bus>(new bus("adu_sl_bus"));
-    mem_slb_bus = unique_ptr<bus>(new bus("mem_slb_bus"));
-    iq_rob_bus = unique_ptr<bus>(new bus("iq_rob_bus"));
-    rob_statval_bus = unique_ptr<cons_bus_fast>(new cons_bus_fast("rob_statval_bus"));//Este canal se comunida com rs_ctrl_r e com adu
-    rob_adu_bus = unique_ptr<cons_bus>(new cons_bus("rob_adu_bus")); //usado para flush
-    inst_bus = unique_ptr<cons_bus>(new cons_bus("inst_bus"));
-    rst_bus = unique_ptr<cons_bus>(new cons_bus("rst_bus"));
-    sl_bus = unique_ptr<cons_bus>(new cons_bus("sl_bus"));
-    rob_bus = unique_ptr<cons_bus>(new cons_bus("rob_bus"));
-    ad_bus = unique_ptr<cons_bus>(new cons_bus("ad_bus"));
-    rob_slb_bus = unique_ptr<cons_bus_fast>(new cons_bus_fast("rob_slb_bus"));
-    rb_bus = unique_ptr<cons_bus_fast>(new cons_bus_fast("rb_bus"));
-
-    clk = unique_ptr<clock_>(new clock_("clock",1,ccount));
-    iss_ctrl_r = unique_ptr<issue_control_rob>(new issue_control_rob("issue_control_rob"));
-    fila_r = unique_ptr<instruction_queue_rob>(new instruction_queue_rob("fila_inst_rob",instruct_queue,rob_size,instr_gui));
-    rob = unique_ptr<reorder_buffer>(new reorder_buffer("rob",rob_size, n_bits, bpb_size, 2, rob_gui,instr_gui.at(0)));
-    adu = unique_ptr<address_unit>(new address_unit("address_unit",instruct_time["MEM"],instr_gui.at(0),table.at(0),nadd+nmul));
-    rs_ctrl_r = unique_ptr<res_vector_rob>(new res_vector_rob("rs_vc",nadd,nmul,instruct_time,table,instr_gui.at(0),rob_gui.at(0)));
-    rb_r = unique_ptr<register_bank_rob>(new register_bank_rob("register_bank_rob",regs));
-    slb_r = unique_ptr<sl_buffer_rob>(new sl_buffer_rob("sl_buffer_rob",nload,nadd+nmul,instruct_time,table,instr_gui.at(0),rob_gui.at(0)));
-    mem_r = unique_ptr<memory_rob>(new memory_rob("memory_rob", mem_gui));
-
-    clk->out(*clock_bus);
-
-    fila_r->in(*clock_bus);
-    fila_r->out(*inst_bus);
-    fila_r->in_rob(*iq_rob_bus);
-
-    iss_ctrl_r->in(*inst_bus);
-    iss_ctrl_r->out_rsv(*rst_bus);
-    iss_ctrl_r->out_slbuff(*sl_bus);
-    iss_ctrl_r->in_slbuff(*sl_bus);
-    iss_ctrl_r->in_rob(*rob_bus);
-    iss_ctrl_r->out_rob(*rob_bus);
-    iss_ctrl_r->out_adu(*ad_bus);
+    if(!core_id)
+        return name;
+    return name + "_" + std::to_string(core_id);
+}
 
-    rob->in_issue(*rob_bus);
-    rob->out_issue(*rob_bus);
-    rob->in_cdb(*CDB);
-    rob->in_rb(*rb_bus);
-    rob->out_rb(*rb_bus);
-    rob->out_mem(*mem_bus);
-    rob->in_adu(*adu_bus);
-    rob->out_iq(*iq_rob_bus);
-    rob->in_resv_adu(*rob_statval_bus);
-    rob->out_resv_adu(*rob_statval_bus);
-    rob->in_slb(*rob_slb_bus);
-    rob->out_slb(*rob_slb_bus);
-    rob->out_adu(*rob_adu_bus);
+// Multicore: cria os nucleos 1.., cada um com a sua janela, os seus
+// registradores (copias dos do nucleo 0) e a sua cache ligada ao barramento.
+// Os nucleos sem programa proprio executam a fila principal, com os enderecos
+// deslocados para a sua regiao de memoria se CORE_MEM_STRIDE for informado
+void top::build_cores(int n_bits, int bpb_size, int bpb_mode, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, map<string,int> config, vector<string> instruct_queue, nana::grid &mem_gui, nana::listbox &regs)
+{
+    unsigned int stride = config["CORE_MEM_STRIDE"];
+    for(unsigned int c = 1 ; c < (unsigned int)config["CORES"] ; c++)
+    {
+        vector<string> &src = c-1 < thread_programs.size() ? thread_programs[c-1] : instruct_queue;
+        vector<string> program;
+        core_gui.push_back(unique_ptr<core_window>(new core_window(c,regs)));
+        core_window &w = *core_gui.back();
+        auto instr_cat = w.instruct.at(0);
+        for(unsigned int i = 0 ; i < src.size() ; i++)
+        {
+            program.push_back(thread_select::rename(src[i],0,c*stride));
+            instr_cat.append(program.back());
+        }
+        copy_region(mem_gui,stride,c);
+        string name = "top_" + std::to_string(c);
+        cores.push_back(unique_ptr<top>(new top(name.c_str())));
+        cores.back()->core_id = c;
+        cores.back()->shared_bus = shared_bus;
+        cores.back()->rob_build(n_bits,bpb_size,bpb_mode,nadd,nmul,nload,instruct_time,config,program,w.table,mem_gui,w.reg,w.instruct,w.clock_count,w.rob);
+    }
+}
 
-    adu->in_issue(*ad_bus);
-    adu->in_cdb(*CDB);
-    adu->out_slbuff(*adu_sl_bus);
-    adu->in_rob(*rob_adu_bus);
-    adu->out_rob(*adu_bus);
-    adu->in_rb(*rb_bus);
-    adu->out_rb(*rb_bus);
-    adu->in_rob_svl(*rob_statval_bus);
-    adu->out_rob_svl(*rob_statval_bus);
+//Copia a regiao de memoria [0,stride) para a regiao k; check_regions
+//garante que a regiao cabe na memoria
+void top::copy_region(nana::grid &mem_gui, unsigned int stride, unsigned int k)
+{
+    for(unsigned int i = 0 ; i < stride ; i++)
+        mem_gui.Set(k*stride+i,mem_gui.Get(i));
+}
 
-    rs_ctrl_r->in_issue(*rst_bus);
-    rs_ctrl_r->in_cdb(*CDB);
-    rs_ctrl_r->out_cdb(*CDB);
-    rs_ctrl_r->in_rb(*rb_bus);
-    rs_ctrl_r->out_rb(*rb_bus);
-    rs_ctrl_r->out_mem(*mem_bus);
-    rs_ctrl_r->in_rob(*rob_statval_bus);
-    rs_ctrl_r->out_rob(*rob_statval_bus);
+vector<string> top::check_regions(map<string,int> config, unsigned int mem_words)
+{
+    vector<string> err;
+    unsigned long threads = config["SMT_THREADS"];
+    unsigned long stride = config["SMT_MEM_STRIDE"];
+    //Mesma condicao de rob_build: o multicore desliga o SMT
+    if(threads > 1 && !config["CORES"] && threads*stride > mem_words)
+        err.push_back("SMT_THREADS " + std::to_string(threads) + " x SMT_MEM_STRIDE " + std::to_string(stride) +
+                      " = " + std::to_string(threads*stride) + " palavras, mas a memoria tem " + std::to_string(mem_words));
+    unsigned long ncores = config["CORES"];
+    stride = config["CORE_MEM_STRIDE"];
+    if(ncores > 1 && ncores*stride > mem_words)
+        err.push_back("CORES " + std::to_string(ncores) + " x CORE_MEM_STRIDE " + std::to_string(stride) +
+                      " = " + std::to_string(ncores*stride) + " palavras, mas a memoria tem " + std::to_string(mem_words));
+    return err;
+}
 
-    slb_r->in_issue(*sl_bus);
-    slb_r->out_issue(*sl_bus);
-    slb_r->in_cdb(*CDB);
-    slb_r->out_cdb(*CDB);
-    slb_r->out_mem(*mem_bus);
-    slb_r->in_adu(*adu_sl_bus);
-    slb_r->in_mem(*mem_slb_bus);
-    slb_r->in_rob(*rob_slb_bus);
-    slb_r->out_rob(*rob_slb_bus);
+bool top::rob_finished()
+{
+    if(!get_rob_queue().queue_is_empty() || !get_rob().rob_is_empty())
+        return false;
+    for(unsigned int c = 0 ; c < cores.size() ; c++)
+        if(!cores[c]->rob_finished())
+            return false;
+    return true;
+}
 
-    rb_r->in(*rb_bus);
-    rb_r->out(*rb_bus);
+void top::add_thread(vector<string> program)
+{
+    thread_programs.push_back(program);
+}
 
-    mem_r->in(*mem_bus);
-    mem_r->out(*CDB);
-    mem_r->out_slb(*mem_slb_bus);
+// SMT: programa de cada thread, com os registradores renomeados para os da
+// thread e os enderecos deslocados para a sua regiao de memoria. As threads
+// sem programa proprio executam a fila principal. Os registradores e a regiao
+// de memoria das threads 1.. comecam como copias dos da thread 0, e a fila da
+// interface passa a intercalar as instrucoes das threads
+vector<vector<string>> top::smt_programs(unsigned int threads, unsigned int stride, vector<string> instruct_queue, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr_gui)
+{
+    vector<vector<string>> programs(threads);
+    auto reg_cat = regs.at(0);
+    unsigned int longest = 0;
+    programs[0] = instruct_queue;
+    for(unsigned int t = 1 ; t < threads ; t++)
+    {
+        vector<string> &src = t-1 < thread_programs.size() ? thread_programs[t-1] : instruct_queue;
+        for(unsigned int i = 0 ; i < src.size() ; i++)
+            programs[t].push_back(thread_select::rename(src[i],t,t*stride));
+        for(unsigned int i = 0 ; i < 32 ; i++)
+            reg_cat.append({"R" + std::to_string(32*t+i),reg_cat.at(i).text(1),"0","F" + std::to_string(32*t+i),reg_cat.at(i).text(4),"0","V" + std::to_string(32*t+i),reg_cat.at(i).text(7),"0"});
+        copy_region(mem_gui,stride,t);
+    }
+    for(unsigned int t = 0 ; t < threads ; t++)
+        longest = std::max(longest,(unsigned int)programs[t].size());
+    instr_gui.clear(0);
+    auto instr_cat = instr_gui.at(0);
+    for(unsigned int i = 0 ; i < longest ; i++)
+        for(unsigned int t = 0 ; t < threads ; t++)
+            instr_cat.append(i < programs[t].size() ? programs[t][i] : "");
+    return programs;
 }
 
 void top::metrics(int cpu_freq, int mode, string bench_name, int n_bits) {
@@ -255,6 +387,10 @@ void top::metrics(int cpu_freq, int mode, string bench_name, int n_bits) {
 
     if(fila_r != NULL && rob != NULL){
         unsigned int total_instructions_exec = get_rob_queue().get_instruction_counter();
+        for(unsigned int t = 0 ; t < fila_smt.size() ; t++)
+            total_instructions_exec += fila_smt[t]->get_instruction_counter();
+        for(unsigned int c = 0 ; c < cores.size() ; c++)
+            total_instructions_exec += cores[c]->get_rob_queue().get_instruction_counter();
         
         double cpi_medio = (double) ciclos / total_instructions_exec;
         
@@ -282,6 +418,7 @@ void top::metrics(int cpu_freq, int mode, string bench_name, int n_bits) {
             tam_bpb = get_rob().get_bpb().get_bpb_size();
             cout << "# Taxa de sucesso - BPB[" << tam_bpb << "]: " << hit_rate << "%" << endl;
         }
+        spec_metrics(cout);
 
         dump_metrics(bench_name, cpu_freq, total_instructions_exec, ciclos, cpi_medio, t_cpu, mips,
                      mode, hit_rate, tam_bpb, mem_count, n_bits);
@@ -324,6 +461,192 @@ void top::dump_metrics(string bench_name, int cpu_freq, unsigned int total_instr
         hit_rate = get_rob().get_bpb().bpb_get_hit_rate();
         out_file << "# Taxa de sucesso - BPB[" << tam_bpb << "]: " << hit_rate << "%" << endl;
     }
+    spec_metrics(out_file);
     
     out_file.close();
 }
+
+// Estatisticas dos recursos do modo com especulacao
+void top::spec_metrics(std::ostream &out)
+{
+    out <<
+    "# Politica de selecao: " << res_pool_rob::policy_name(pool->get_policy()) << "\n" <<
+    "# Selecoes para unidades compartilhadas: " << pool->get_select_count() << "\n" <<
+    "# Selecoes com disputa: " << pool->get_contention_count() << "\n" <<
+    "# Selecoes diferentes da ordem por indice: " << pool->get_changed_count() << "\n" <<
+    "# Selecoes diferentes da mais antiga: " << pool->get_oldest_changed() << endl;
+    if(pool->is_unified())
+        out << "# Estacoes de reserva: janela unificada com " << pool->get_window() << " entradas" << endl;
+    else
+        out << "# Estacoes de reserva: distribuidas por classe" << endl;
+    out <<
+    "# Ocupacao media das estacoes: " << pool->get_avg_occupancy() << "\n" <<
+    "# Ocupacao media (add/mult/load): " << pool->get_class_avg_occupancy(0) << "/" << pool->get_class_avg_occupancy(1) << "/" << pool->get_class_avg_occupancy(2) << "\n" <<
+    "# Pico de ocupacao (add/mult/load): " << pool->get_class_peak(0) << "/" << pool->get_class_peak(1) << "/" << pool->get_class_peak(2) << "\n" <<
+    "# Issue bloqueado por falta de estacao: " << pool->get_full_stalls() << "\n" <<
+    "# Conflitos de porta no banco de registradores (leitura/escrita): " << rb_r->get_read_conflicts() << "/" << rb_r->get_write_conflicts() << "\n" <<
+    "# Operandos pela rede de bypass (acertos/misses): " << pool->get_bypass_hits() << "/" << pool->get_bypass_misses() << endl;
+    if(pool->get_clusters() > 1)
+    {
+        out << "# Clusters: " << pool->get_clusters() << ", escolha por " << res_pool_rob::steer_name(pool->get_steer()) << ", instrucoes por cluster:";
+        for(unsigned int c = 0 ; c < pool->get_clusters() ; c++)
+            out << " " << pool->get_cluster_issued(c);
+        out << "\n" <<
+        "# Operandos no mesmo cluster/entre clusters: " << pool->get_cluster_local() << "/" << pool->get_cluster_cross() << "\n" <<
+        "# Instrucoes enviadas ao cluster do produtor: " << pool->get_steer_follow() << endl;
+    }
+    out <<
+    "# Pares fundidos em macro-ops (issue/commit): " << fila_r->get_fused_count() << "/" << rob->get_fused_commits() << "\n" <<
+    "# Issue bloqueado por ROB cheio: " << rob->get_full_stalls() << "\n" <<
+    "# Flushes por desvio mal previsto: " << rob->get_branch_flushes() << "\n" <<
+    "# Movimentos condicionais (MOVZ/MOVN) commitados: " << rob->get_cmov_count() << "\n" <<
+    "# Instrucoes eliminadas no rename (zeramento/copia): " << rob->get_elim_zero() << "/" << rob->get_elim_move() << "\n" <<
+    "# Copias executadas com a origem pendente: " << rob->get_elim_missed() << endl;
+    // No SMT cada thread tem a sua busca; os totais somam todas
+    vector<instruction_queue_rob*> filas = {fila_r.get()};
+    for(unsigned int t = 0 ; t < fila_smt.size() ; t++)
+        filas.push_back(fila_smt[t].get());
+    if(fila_r->get_ftq_size())
+    {
+        unsigned int blocks = 0, stalls = 0, resteers = 0, hidden = 0;
+        double occ = 0;
+        for(unsigned int t = 0 ; t < filas.size() ; t++)
+        {
+            blocks += filas[t]->get_ftq_blocks();
+            stalls += filas[t]->get_ftq_stalls();
+            resteers += filas[t]->get_ftq_resteers();
+            hidden += filas[t]->get_ftq_hidden();
+            occ += filas[t]->get_ftq_occupancy();
+        }
+        out <<
+        "# Fila de alvos de busca (FTQ): " << fila_r->get_ftq_size() << " blocos por thread" << "\n" <<
+        "# Blocos previstos: " << blocks << ", ocupacao media da FTQ: " << occ/filas.size() << "\n" <<
+        "# Busca parada esperando o bloco da FTQ (ciclos): " << stalls << "\n" <<
+        "# Redirecionamentos da FTQ: " << resteers << "\n" <<
+        "# Bolha de decodificacao escondida pela FTQ (ciclos): " << hidden << endl;
+    }
+    uop_cache &uc = fila_r->get_uop_cache();
+    if(uc.enabled())
+    {
+        unsigned int decoded = 0, hits = 0, lsd = 0, captures = 0, redirects = 0, bubbles = 0, saved = 0;
+        for(unsigned int t = 0 ; t < filas.size() ; t++)
+        {
+            uop_cache &u = filas[t]->get_uop_cache();
+            decoded += u.get_decoded();
+            hits += u.get_uop_hits();
+            lsd += u.get_lsd_instr();
+            captures += u.get_lsd_captures();
+            redirects += u.get_redirects();
+            bubbles += u.get_bubbles();
+            saved += u.get_saved();
+        }
+        unsigned int total = decoded + hits + lsd;
+        out <<
+        "# Decodificacao: " << uc.get_latency() << " ciclos, cache de micro-ops com " << uc.get_entries() << " instrucoes, LSD de " << uc.get_lsd_size() << " instrucoes" << "\n" <<
+        "# Instrucoes decodificadas/da cache de micro-ops/do LSD: " << decoded << "/" << hits << "/" << lsd << " (" << (total ? 100.0*(hits+lsd)/total : 0) << "% sem decodificar)" << "\n" <<
+        "# Lacos travados no LSD: " << captures << "\n" <<
+        "# Reinicios da busca: " << redirects << ", bolhas de decodificacao (ciclos): " << bubbles << "\n" <<
+        "# Busca poupada pela cache de micro-ops e pelo LSD (ciclos): " << saved << endl;
+    }
+    unsigned int loop_taken = 0, loop_exits = 0, loop_waits = 0;
+    for(unsigned int t = 0 ; t < filas.size() ; t++)
+    {
+        loop_unit &lu = filas[t]->get_loop_unit();
+        loop_taken += lu.get_taken();
+        loop_exits += lu.get_exits();
+        loop_waits += lu.get_waits();
+    }
+    if(loop_taken + loop_exits)
+        out << "# Lacos em hardware (LOOP): " << loop_taken << " saltos, " << loop_exits << " saidas, busca parada esperando o contador em " << loop_waits << " ciclos" << endl;
+    if(rob->get_vec_count())
+        out << "# Instrucoes vetoriais: " << rob->get_vec_count() << " de " << pool->get_vlen() << " elementos, " << pool->get_vwidth() << " por ciclo na unidade vetorial" << endl;
+    value_predictor &vp = rob->get_value_pred();
+    if(vp.get_mode() != value_predictor::VP_OFF)
+    {
+        unsigned int pred = vp.get_predictions();
+        //Previsoes de loads descartados por flush nao sao conferidas
+        unsigned int checked = rob->get_vp_correct() + rob->get_vp_replays();
+        out <<
+        "# Preditor de valor de loads: " << value_predictor::mode_name(vp.get_mode()) << ", " << vp.get_size() << " entradas" << "\n" <<
+        "# Loads com valor previsto (cobertura): " << pred << "/" << vp.get_lookups() << " (" << (vp.get_lookups() ? 100.0*pred/vp.get_lookups() : 0) << "%)" << "\n" <<
+        "# Previsoes de valor corretas (acuracia nos loads commitados): " << rob->get_vp_correct() << "/" << checked << " (" << (checked ? 100.0*rob->get_vp_correct()/checked : 0) << "%)" << "\n" <<
+        "# Replays por valor previsto incorreto: " << rob->get_vp_replays() << "\n" <<
+        "# Ciclos antecipados pelos dependentes do valor previsto: " << rob->get_vp_hidden() << endl;
+    }
+    if(dcache->enabled())
+    {
+        out <<
+        "# Cache de dados: " << dcache->get_lines() << " linhas de " << dcache->get_block() << " palavras, miss de " << dcache->get_miss_latency() << " ciclos" << "\n" <<
+        "# Loads na cache de dados (acertos/misses/misses secundarios): " << dcache->get_hits() << "/" << dcache->get_misses() << "/" << dcache->get_merged() << "\n" <<
+        "# Prefetches emitidos (usados por loads): " << dcache->get_prefetches() << " (" << dcache->get_useful_prefetches() << ")" << endl;
+        //Prefetch por software e stores nao temporais: so com PREF/SDNT no programa
+        if(dcache->get_sw_prefetches() || dcache->get_sw_dropped())
+            out << "# Prefetches do PREF (linha ja presente/usados por loads/substituidos sem uso): " << dcache->get_sw_prefetches() <<
+            " (" << dcache->get_sw_dropped() << "/" << dcache->get_sw_useful() << "/" << dcache->get_sw_unused() << ")" << endl;
+        if(dcache->get_stream_stores())
+            out << "# Stores nao temporais (SDNT): " << dcache->get_stream_stores() << endl;
+    }
+    if(ra)
+    {
+        out <<
+        "# Episodios de runahead (ciclos em runahead): " << ra->get_episodes() << " (" << ra->get_cycles() << ")" << "\n" <<
+        "# Instrucoes pre-executadas no runahead (com operando INV): " << ra->get_executed() << " (" << ra->get_invalid() << ")" << endl;
+    }
+    if(smt)
+    {
+        double low = 0,high = 0;
+        out << "# SMT: " << smt->get_threads() << " threads, busca por " << thread_select::policy_name(smt->get_policy()) << ", " << smt->get_partition() << " entradas do ROB por thread" << endl;
+        for(unsigned int t = 0 ; t < smt->get_threads() ; t++)
+        {
+            unsigned int instr = t ? fila_smt[t-1]->get_instruction_counter() : fila_r->get_instruction_counter();
+            unsigned int end = smt->get_finish(t);
+            double ipc = end ? (double)instr/end : 0;
+            if(!t || ipc < low)
+                low = ipc;
+            if(!t || ipc > high)
+                high = ipc;
+            out << "# Thread " << t << ": " << instr << " instrucoes, ultimo commit no ciclo " << end << ", IPC " << ipc << ", ciclos com a busca " << smt->get_fetched(t) << endl;
+        }
+        out << "# Justica entre as threads (menor/maior IPC): " << (high > 0 ? low/high : 0) << endl;
+    }
+    if(snoop)
+    {
+        double cycles = sc_time_stamp().to_double() / 1000 - 1;
+        out << "# Multicore: " << cores.size()+1 << " nucleos, L1 privada de " << dcache->get_lines() << " linhas, barramento MESI de " << snoop->get_latency() << " ciclos por transacao" << endl;
+        for(unsigned int c = 0 ; c <= cores.size() ; c++)
+        {
+            top &core = c ? *cores[c-1] : *this;
+            data_cache &l1 = *core.dcache;
+            unsigned int instr = core.fila_r->get_instruction_counter();
+            out << "# Nucleo " << c << ": " << instr << " instrucoes, IPC " << (cycles > 0 ? instr/cycles : 0) <<
+            ", loads na L1 (acertos/misses) " << l1.get_hits() << "/" << l1.get_misses() <<
+            ", stores na L1 (acertos/misses) " << l1.get_store_hits() << "/" << l1.get_store_misses() <<
+            ", invalidacoes recebidas " << l1.get_invalidations() << ", writebacks " << l1.get_writebacks() << endl;
+        }
+        out << "# Transacoes no barramento:";
+        for(int type = snoop_bus::BUS_RD ; type <= snoop_bus::BUS_WB ; type++)
+            out << " " << snoop_bus::type_name(type) << " " << snoop->get_count(type);
+        out << " (total " << snoop->get_transactions() << ", " << snoop->get_transfers() << " blocos entre caches)" << "\n" <<
+        "# Utilizacao do barramento: " << snoop->get_busy_cycles() << " ciclos ocupado (" << (cycles > 0 ? 100.0*snoop->get_busy_cycles()/cycles : 0) << "%)" << "\n" <<
+        "# Espera pelo barramento: " << snoop->get_wait_cycles() << " ciclos" << endl;
+    }
+    //Sincronizacao: so com LLD/SCD ou SYNC no programa
+    for(unsigned int c = 0 ; c <= cores.size() ; c++)
+    {
+        top &core = c ? *cores[c-1] : *this;
+        reorder_buffer &r = *core.rob;
+        if(!r.get_ll_count() && !r.get_sc_count() && !r.get_fences())
+            continue;
+        out << "# Sincronizacao" << (snoop ? " no nucleo " + std::to_string(c) : "") << ": LLD " << r.get_ll_count() <<
+        ", SCD " << r.get_sc_count() << " (falhas " << r.get_sc_fails() << "), reservas desfeitas por stores " << core.dcache->get_link_breaks() <<
+        ", SYNC " << r.get_fences() << ", loads retidos por SYNC " << r.get_fence_loads() << " (" << r.get_fence_stall() << " ciclos de espera)" << endl;
+    }
+    if(pool->get_policy() == res_pool_rob::SEL_PREDICTED || CDB->get_arbitration())
+    {
+        crit_predictor &crit = pool->get_crit();
+        out <<
+        "# Preditor de criticidade: " << crit.get_size() << " entradas" << "\n" <<
+        "# Treinos do preditor: " << crit.get_updates() << " (" << crit.get_critical_updates() << " criticos)" << "\n" <<
+        "# Escritas no CDB adiantadas pela prioridade: " << CDB->get_prio_wins() << endl;
+    }
+}
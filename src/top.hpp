@@ -20,6 +20,10 @@
 #include "memory_rob.hpp"
 #include "instruction_queue_rob.hpp"
 #include "address_unit.hpp"
+#include "res_pool_rob.hpp"
+#include "thread_select.hpp"
+#include "snoop_bus.hpp"
+#include "gui.hpp"
 
 
 using std::unique_ptr;
@@ -29,12 +33,21 @@ class top: public sc_module
 public:
     top(sc_module_name name);
     void simple_mode(unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time,vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr, nana::label &ccount);
-    void rob_mode(int n_bits, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr, nana::label &count, nana::listbox &rob_gui);
-    void rob_mode_bpb(int n_bits, int bpb_size, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr, nana::label &count, nana::listbox &rob_gui);
+    void rob_mode(int n_bits, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, map<string,int> config, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr, nana::label &count, nana::listbox &rob_gui);
+    void rob_mode_bpb(int n_bits, int bpb_size, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, map<string,int> config, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr, nana::label &count, nana::listbox &rob_gui);
 
     instruction_queue_rob & get_rob_queue() {return *fila_r;}
     instruction_queue & get_queue() {return *fila;}
     reorder_buffer & get_rob() {return *rob;}
+    // Programa de mais uma thread do SMT ou de mais um nucleo do multicore
+    // (a thread 0 e o nucleo 0 executam a fila principal)
+    void add_thread(vector<string> program);
+    // Modo com especulacao: filas e ROBs vazios em todos os nucleos
+    bool rob_finished();
+    // Confere se as regioes de memoria das threads e dos nucleos cabem nos
+    // mem_words da memoria; retorna os erros, vazio se a configuracao pode
+    // ser montada
+    static vector<string> check_regions(map<string,int> config, unsigned int mem_words);
 
     void metrics(int cpu_freq, int mode, string bench_name, int n_bits);
 
@@ -58,12 +71,30 @@ private:
     unique_ptr<address_unit> adu;
     unique_ptr<issue_control_rob> iss_ctrl_r;
     unique_ptr<reorder_buffer> rob;
+    unique_ptr<res_pool_rob> pool;
     unique_ptr<res_vector_rob> rs_ctrl_r;
     unique_ptr<sl_buffer_rob> slb_r;
     unique_ptr<register_bank_rob> rb_r;
     unique_ptr<memory_rob> mem_r;
     unique_ptr<instruction_queue_rob> fila_r;
+    unique_ptr<data_cache> dcache;
+    unique_ptr<runahead> ra;
+    unique_ptr<thread_select> smt;
+    vector<unique_ptr<instruction_queue_rob>> fila_smt; //filas das threads 1.. no SMT
+    vector<vector<string>> thread_programs;
+    //Multicore: o nucleo 0 cria o barramento e os nucleos 1..
+    unsigned int core_id;
+    snoop_bus *shared_bus;
+    unique_ptr<snoop_bus> snoop;
+    vector<unique_ptr<core_window>> core_gui;
+    vector<unique_ptr<top>> cores;
 
+    void rob_build(int n_bits, int bpb_size, int bpb_mode, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, map<string,int> config, vector<string> instruct_queue, nana::listbox &table, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr, nana::label &count, nana::listbox &rob_gui);
+    vector<vector<string>> smt_programs(unsigned int threads, unsigned int stride, vector<string> instruct_queue, nana::grid &mem_gui, nana::listbox &regs, nana::listbox &instr_gui);
+    void build_cores(int n_bits, int bpb_size, int bpb_mode, unsigned int nadd, unsigned int nmul,unsigned int nload,map<string,int> instruct_time, map<string,int> config, vector<string> instruct_queue, nana::grid &mem_gui, nana::listbox &regs);
+    void copy_region(nana::grid &mem_gui, unsigned int stride, unsigned int k);
+    string unit_name(string name);
+    void spec_metrics(std::ostream &out);
     void dump_metrics(string bench_name, int cpu_freq, unsigned int total_instructions_exec,
                        double ciclos, double cpi_medio, double t_cpu, double mips, int mode,
                        float hit_rate, int tam_bpb, int mem_count, int n_bits);
@@ -0,0 +1,149 @@
+#include "uop_cache.hpp"
+
+uop_cache::uop_cache(unsigned int entries, unsigned int lsd_size, unsigned int latency):
+entries(entries),
+lsd_size(lsd_size),
+latency(latency)
+{
+    locked = false;
+    lsd_start = lsd_end = lsd_count = 0;
+    redirects = decoded = uop_hits = lsd_instr = lsd_captures = 0;
+    bubbles = saved = 0;
+}
+
+bool uop_cache::enabled()
+{
+    return latency || entries || lsd_size;
+}
+
+unsigned int uop_cache::redirect(unsigned int last, unsigned int opc)
+{
+    redirects++;
+    // Desvio que fica dentro do corpo do laco (um if no corpo) nao o desfaz
+    bool inside = lsd_count && last >= lsd_start && last <= lsd_end && opc >= lsd_start && opc <= lsd_end;
+    // Desvio para tras com o corpo cabendo no LSD
+    if(lsd_size && last >= opc && last - opc + 1 <= lsd_size)
+    {
+        if(lsd_start == opc && lsd_end == last)
+            lsd_count++;
+        else if(!inside)
+        {
+            locked = false;
+            lsd_start = opc;
+            lsd_end = last;
+            lsd_count = 1;
+        }
+        if(!locked && lsd_count >= 2)
+        {
+            locked = true;
+            lsd_captures++;
+        }
+    }
+    else if(!inside)
+    {
+        locked = false;
+        lsd_count = 0;
+    }
+    if(locked || (entries && where.count(opc)))
+        return 0;
+    bubbles += latency;
+    return latency;
+}
+
+void uop_cache::deliver(unsigned int opc)
+{
+    // Busca seguiu para fora do corpo do laco
+    if(lsd_count && (opc < lsd_start || opc > lsd_end))
+    {
+        locked = false;
+        lsd_count = 0;
+    }
+    if(locked)
+    {
+        lsd_instr++;
+        return;
+    }
+    if(!entries)
+    {
+        decoded++;
+        return;
+    }
+    auto it = where.find(opc);
+    if(it != where.end())
+    {
+        uop_hits++;
+        lru.erase(it->second);
+    }
+    else
+    {
+        decoded++;
+        if(lru.size() >= entries)
+        {
+            where.erase(lru.back());
+            lru.pop_back();
+        }
+    }
+    lru.push_front(opc);
+    where[opc] = lru.begin();
+}
+
+unsigned int uop_cache::get_entries()
+{
+    return entries;
+}
+
+unsigned int uop_cache::get_lsd_size()
+{
+    return lsd_size;
+}
+
+unsigned int uop_cache::get_latency()
+{
+    return latency;
+}
+
+unsigned int uop_cache::get_redirects()
+{
+    return redirects;
+}
+
+unsigned int uop_cache::get_decoded()
+{
+    return decoded;
+}
+
+unsigned int uop_cache::get_uop_hits()
+{
+    return uop_hits;
+}
+
+unsigned int uop_cache::get_lsd_instr()
+{
+    return lsd_instr;
+}
+
+unsigned int uop_cache::get_lsd_captures()
+{
+    return lsd_captures;
+}
+
+unsigned int uop_cache::get_bubbles()
+{
+    return bubbles;
+}
+
+void uop_cache::count_saved()
+{
+    saved++;
+}
+
+void uop_cache::discard_saved(unsigned int since)
+{
+    if(saved > since)
+        saved = since;
+}
+
+unsigned int uop_cache::get_saved()
+{
+    return saved;
+}
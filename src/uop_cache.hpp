@@ -0,0 +1,51 @@
+#pragma once
+#include<list>
+#include<map>
+
+using std::list;
+using std::map;
+
+// Caminhos da busca que evitam a decodificacao. Sem eles, cada vez que a
+// busca recomeca em outro endereco (desvio tomado ou redirecionamento) a
+// decodificacao custa latency ciclos de bolha. A cache de micro-ops guarda
+// as instrucoes ja decodificadas (entries instrucoes, LRU) e entrega sem
+// bolha um fluxo que comeca em uma delas. O detector de laco (LSD) trava um
+// laco de ate lsd_size instrucoes depois de duas iteracoes seguidas pelo
+// mesmo desvio para tras; travado, o corpo e reenviado pelo buffer de laco
+// ate a busca sair dele.
+class uop_cache
+{
+public:
+    uop_cache(unsigned int entries = 0, unsigned int lsd_size = 0, unsigned int latency = 0);
+    bool enabled();
+    // Busca recomeca em opc depois da instrucao last: ciclos de bolha
+    unsigned int redirect(unsigned int last, unsigned int opc);
+    // Instrucao no PC original opc entregue ao issue
+    void deliver(unsigned int opc);
+    // Ciclo em que a busca enviou uma instrucao que, sem a cache de micro-ops
+    // ou o LSD, ainda estaria na bolha de um reinicio evitado
+    void count_saved();
+    // Desfaz os ciclos contados depois que o total era since (caminho
+    // descartado por um redirecionamento)
+    void discard_saved(unsigned int since);
+    unsigned int get_entries();
+    unsigned int get_lsd_size();
+    unsigned int get_latency();
+    unsigned int get_redirects();
+    unsigned int get_decoded();
+    unsigned int get_uop_hits();
+    unsigned int get_lsd_instr();
+    unsigned int get_lsd_captures();
+    unsigned int get_bubbles();
+    unsigned int get_saved();
+
+private:
+    unsigned int entries,lsd_size,latency;
+    list<unsigned int> lru; //PCs na cache de micro-ops, mais recente na frente
+    map<unsigned int,list<unsigned int>::iterator> where;
+    bool locked; //laco travado no LSD
+    unsigned int lsd_start,lsd_end; //corpo do laco candidato ou travado
+    unsigned int lsd_count; //iteracoes seguidas do laco candidato
+    unsigned int redirects,decoded,uop_hits,lsd_instr,lsd_captures;
+    unsigned int bubbles,saved;
+};
@@ -0,0 +1,82 @@
+#include "value_predictor.hpp"
+
+value_predictor::value_predictor(unsigned int t, int mode, unsigned int threshold):
+table(t ? t : 1,{false,0,0,0,0}),
+mode(mode),
+threshold(threshold)
+{
+    lookups = 0;
+    predictions = 0;
+}
+
+bool value_predictor::predict(unsigned int pc, unsigned int n, float &value)
+{
+    if(mode == VP_OFF)
+        return false;
+    vp_entry &e = table[pc%table.size()];
+    lookups++;
+    if(!e.valid || e.tag != pc || e.conf < threshold)
+        return false;
+    value = e.last;
+    if(mode == VP_STRIDE)
+        value += e.stride*(n+1);
+    predictions++;
+    return true;
+}
+
+void value_predictor::update(unsigned int pc, float value)
+{
+    if(mode == VP_OFF)
+        return;
+    vp_entry &e = table[pc%table.size()];
+    if(!e.valid || e.tag != pc)
+    {
+        e = {true,pc,value,0,0};
+        return;
+    }
+    float expected = mode == VP_STRIDE ? e.last + e.stride : e.last;
+    if(value == expected)
+    {
+        if(e.conf < 3)
+            e.conf++;
+    }
+    else
+    {
+        e.conf = 0;
+        e.stride = value - e.last;
+    }
+    e.last = value;
+}
+
+int value_predictor::get_mode()
+{
+    return mode;
+}
+
+string value_predictor::mode_name(int mode)
+{
+    switch(mode)
+    {
+        case VP_LAST:
+            return "Ultimo valor";
+        case VP_STRIDE:
+            return "Stride";
+        default:
+            return "Desligado";
+    }
+}
+
+unsigned int value_predictor::get_size()
+{
+    return table.size();
+}
+
+unsigned int value_predictor::get_lookups()
+{
+    return lookups;
+}
+
+unsigned int value_predictor::get_predictions()
+{
+    return predictions;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include<vector>
+#include<string>
+
+using std::vector;
+using std::string;
+
+// Preditor de valor de loads indexado pelo PC. Cada entrada guarda o ultimo
+// valor lido, o passo entre os dois ultimos valores e um contador de
+// confianca de 2 bits; so ha previsao com a confianca no limiar. No modo
+// VP_LAST o passo e ignorado (preditor de ultimo valor).
+class value_predictor
+{
+public:
+    enum { VP_OFF, VP_LAST, VP_STRIDE };
+
+    value_predictor(unsigned int t = 64, int mode = VP_OFF, unsigned int threshold = 2);
+    // Valor da instancia do load em pc que tem n instancias mais antigas em voo
+    bool predict(unsigned int pc, unsigned int n, float &value);
+    // Treina com o valor real, no commit
+    void update(unsigned int pc, float value);
+    int get_mode();
+    static string mode_name(int mode);
+    unsigned int get_size();
+    unsigned int get_lookups();
+    unsigned int get_predictions();
+
+private:
+    struct vp_entry
+    {
+        bool valid;
+        unsigned int tag;
+        float last,stride;
+        unsigned char conf;
+    };
+    vector<vp_entry> table;
+    int mode;
+    unsigned int threshold;
+    unsigned int lookups,predictions;
+};